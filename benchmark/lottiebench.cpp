@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * Throughput benchmark over a directory of lottie resources.
+ * For every json file it measures the parse time and then renders all
+ * the frames at each of the requested surface sizes and thread counts.
+ * With one thread the frames are rendered one by one with renderSync(),
+ * otherwise up to that many frames are kept in flight with render().
+ * Single thread runs also report the mean time of each render stage
+ * (@see rlottie::FrameStats).
+ * Results are printed as a table and can be written as csv or json, so
+ * that two builds can be compared.
+ */
+
+#include <rlottie.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#else
+#include <windows.h>
+#endif
+
+#ifndef DEMO_DIR
+#define DEMO_DIR "./"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Result {
+    std::string file;
+    size_t      size{0};
+    size_t      threads{0};
+    size_t      frames{0};
+    double      parseMs{0};
+    double      totalMs{0};
+    double      frameMean{0};
+    double      frameP50{0};
+    double      frameP95{0};
+    double      frameMax{0};
+    // mean per frame time of each stage (single thread only).
+    double      updateMs{0};
+    double      preprocessMs{0};
+    double      renderMs{0};
+    double      matteMs{0};
+};
+
+class Benchmark {
+public:
+    int setup(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++) {
+            const char *arg = argv[i];
+            const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+                return help();
+            } else if (!strcmp(arg, "-s") && value) {
+                sizes = parseList(value);
+                i++;
+            } else if (!strcmp(arg, "-t") && value) {
+                threads = parseList(value);
+                i++;
+            } else if (!strcmp(arg, "-p") && value) {
+                parseRuns = std::max(1, atoi(value));
+                i++;
+            } else if (!strcmp(arg, "-b") && value) {
+                bands = size_t(std::max(1, atoi(value)));
+                i++;
+            } else if (!strcmp(arg, "-f") && value) {
+                maxFrames = size_t(std::max(0, atoi(value)));
+                i++;
+            } else if (!strcmp(arg, "-o") && value) {
+                output = value;
+                i++;
+            } else if (arg[0] == '-') {
+                return help();
+            } else {
+                inputs.emplace_back(arg);
+            }
+        }
+        if (inputs.empty()) inputs.emplace_back(DEMO_DIR);
+        if (sizes.empty() || threads.empty()) return help();
+
+        for (const auto &input : inputs) collect(input);
+        std::sort(files.begin(), files.end());
+        if (files.empty()) {
+            std::cout << "No lottie json file found" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    int run()
+    {
+        printHeader();
+        for (const auto &file : files) {
+            std::string json;
+            if (!readFile(file, json)) continue;
+
+            double parseMs = parse(file, json);
+            if (parseMs < 0) {
+                std::cout << basename(file) << " : failed to load" << std::endl;
+                continue;
+            }
+
+            for (auto size : sizes) {
+                for (auto count : threads) {
+                    auto player = rlottie::Animation::loadFromData(
+                        json, file, dirname(file), false);
+                    player->setMaxRenderBands(bands);
+                    Result result = render(*player, size, count);
+                    result.file = basename(file);
+                    result.parseMs = parseMs;
+                    print(result);
+                    results.push_back(result);
+                }
+            }
+        }
+        return write();
+    }
+
+private:
+    static std::vector<size_t> parseList(const char *str)
+    {
+        std::vector<size_t> list;
+        std::stringstream   stream(str);
+        std::string         item;
+        while (std::getline(stream, item, ',')) {
+            int value = atoi(item.c_str());
+            if (value > 0) list.push_back(size_t(value));
+        }
+        return list;
+    }
+
+    static bool jsonFile(const std::string &name)
+    {
+        std::string extn = ".json";
+        return name.size() > extn.size() &&
+               name.compare(name.size() - extn.size(), extn.size(), extn) == 0;
+    }
+
+    static std::string basename(const std::string &str)
+    {
+        return str.substr(str.find_last_of("/\\") + 1);
+    }
+
+    static std::string dirname(const std::string &str)
+    {
+        auto pos = str.find_last_of("/\\");
+        return pos == std::string::npos ? std::string() : str.substr(0, pos + 1);
+    }
+
+    static bool readFile(const std::string &path, std::string &content)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return true;
+    }
+
+    void collect(const std::string &path)
+    {
+        if (jsonFile(path)) {
+            files.push_back(path);
+            return;
+        }
+        std::string dir = path;
+        if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') dir += '/';
+#ifndef _WIN32
+        DIR *handle = opendir(dir.c_str());
+        if (!handle) return;
+        while (dirent *entry = readdir(handle)) {
+            if (jsonFile(entry->d_name)) files.push_back(dir + entry->d_name);
+        }
+        closedir(handle);
+#else
+        WIN32_FIND_DATAA data;
+        HANDLE handle = FindFirstFileA((dir + "*.json").c_str(), &data);
+        if (handle == INVALID_HANDLE_VALUE) return;
+        do {
+            files.push_back(dir + data.cFileName);
+        } while (FindNextFileA(handle, &data));
+        FindClose(handle);
+#endif
+    }
+
+    // best of parseRuns loads, with the model cache bypassed.
+    double parse(const std::string &file, const std::string &json)
+    {
+        double best = -1;
+        for (int i = 0; i < parseRuns; i++) {
+            auto start = Clock::now();
+            auto player = rlottie::Animation::loadFromData(json, file, dirname(file), false);
+            double ms = elapsedMs(start);
+            if (!player) return -1;
+            if (best < 0 || ms < best) best = ms;
+        }
+        return best;
+    }
+
+    Result render(rlottie::Animation &player, size_t size, size_t count)
+    {
+        Result result;
+        result.size = size;
+        result.threads = count;
+        result.frames = player.totalFrame();
+        if (maxFrames && result.frames > maxFrames) result.frames = maxFrames;
+
+        std::vector<uint32_t> buffer(size * size);
+        rlottie::Surface surface(buffer.data(), size, size, size * sizeof(uint32_t));
+
+        // warm up, the first frame also builds the render tree.
+        player.renderSync(0, surface);
+
+        if (count == 1) {
+            std::vector<double> times;
+            times.reserve(result.frames);
+            auto start = Clock::now();
+            rlottie::FrameStats stats;
+            for (size_t i = 0; i < result.frames; i++) {
+                auto frameStart = Clock::now();
+                player.renderSync(i, surface, true, &stats);
+                times.push_back(elapsedMs(frameStart));
+                result.updateMs += stats.updateTime;
+                result.preprocessMs += stats.preprocessTime;
+                result.renderMs += stats.renderTime;
+                result.matteMs += stats.matteTime;
+            }
+            result.totalMs = elapsedMs(start);
+            if (result.frames) {
+                result.updateMs /= result.frames;
+                result.preprocessMs /= result.frames;
+                result.renderMs /= result.frames;
+                result.matteMs /= result.frames;
+            }
+
+            std::sort(times.begin(), times.end());
+            if (!times.empty()) {
+                result.frameP50 = times[times.size() / 2];
+                result.frameP95 = times[std::min(times.size() - 1, times.size() * 95 / 100)];
+                result.frameMax = times.back();
+            }
+        } else {
+            // keep count frames in flight, each one drawing into its own buffer.
+            std::vector<std::vector<uint32_t>>         buffers(count);
+            std::vector<std::future<rlottie::Surface>> inflight(count);
+            for (auto &b : buffers) b.resize(size * size);
+
+            player.setMaxConcurrentRender(count);
+            auto start = Clock::now();
+            for (size_t i = 0; i < result.frames; i++) {
+                size_t slot = i % count;
+                if (inflight[slot].valid()) inflight[slot].wait();
+                inflight[slot] = player.render(
+                    i, rlottie::Surface(buffers[slot].data(), size, size,
+                                        size * sizeof(uint32_t)));
+            }
+            for (auto &f : inflight) {
+                if (f.valid()) f.wait();
+            }
+            result.totalMs = elapsedMs(start);
+        }
+        if (result.frames) result.frameMean = result.totalMs / result.frames;
+        return result;
+    }
+
+    void printHeader() const
+    {
+        std::cout << std::left << std::setw(40) << "file" << std::right
+                  << std::setw(6) << "size" << std::setw(4) << "thr"
+                  << std::setw(7) << "frames" << std::setw(10) << "parse"
+                  << std::setw(10) << "mean" << std::setw(10) << "p95"
+                  << std::setw(10) << "update" << std::setw(10) << "prep"
+                  << std::setw(10) << "render" << std::setw(10) << "matte"
+                  << std::setw(10) << "fps" << std::endl;
+    }
+
+    void print(const Result &r) const
+    {
+        std::cout << std::left << std::setw(40) << r.file.substr(0, 39)
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(6) << r.size << std::setw(4) << r.threads
+                  << std::setw(7) << r.frames << std::setw(10) << r.parseMs
+                  << std::setw(10) << r.frameMean << std::setw(10) << r.frameP95
+                  << std::setw(10) << r.updateMs << std::setw(10) << r.preprocessMs
+                  << std::setw(10) << r.renderMs << std::setw(10) << r.matteMs
+                  << std::setw(10) << std::setprecision(1) << fps(r) << std::endl;
+    }
+
+    static double fps(const Result &r)
+    {
+        return r.totalMs > 0 ? r.frames * 1000.0 / r.totalMs : 0;
+    }
+
+    int write() const
+    {
+        if (output.empty()) return 0;
+
+        std::ofstream file(output);
+        if (!file.is_open()) {
+            std::cout << "Failed to write result file : " << output << std::endl;
+            return 1;
+        }
+        file << std::fixed << std::setprecision(4);
+
+        bool json = output.size() > 5 &&
+                    output.compare(output.size() - 5, 5, ".json") == 0;
+        if (json) {
+            file << "[\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                const auto &r = results[i];
+                file << "  {\"file\": \"" << r.file << "\", \"size\": " << r.size
+                     << ", \"threads\": " << r.threads << ", \"frames\": " << r.frames
+                     << ", \"parse_ms\": " << r.parseMs << ", \"total_ms\": " << r.totalMs
+                     << ", \"frame_mean_ms\": " << r.frameMean
+                     << ", \"frame_p50_ms\": " << r.frameP50
+                     << ", \"frame_p95_ms\": " << r.frameP95
+                     << ", \"frame_max_ms\": " << r.frameMax
+                     << ", \"update_ms\": " << r.updateMs
+                     << ", \"preprocess_ms\": " << r.preprocessMs
+                     << ", \"render_ms\": " << r.renderMs
+                     << ", \"matte_ms\": " << r.matteMs
+                     << ", \"fps\": " << fps(r) << "}"
+                     << (i + 1 < results.size() ? ",\n" : "\n");
+            }
+            file << "]\n";
+        } else {
+            file << "file,size,threads,frames,parse_ms,total_ms,frame_mean_ms,"
+                    "frame_p50_ms,frame_p95_ms,frame_max_ms,update_ms,"
+                    "preprocess_ms,render_ms,matte_ms,fps\n";
+            for (const auto &r : results) {
+                file << '"' << r.file << "\"," << r.size << ',' << r.threads << ','
+                     << r.frames << ',' << r.parseMs << ',' << r.totalMs << ','
+                     << r.frameMean << ',' << r.frameP50 << ',' << r.frameP95 << ','
+                     << r.frameMax << ',' << r.updateMs << ',' << r.preprocessMs << ','
+                     << r.renderMs << ',' << r.matteMs << ',' << fps(r) << '\n';
+            }
+        }
+        std::cout << "Results written to : " << output << std::endl;
+        return 0;
+    }
+
+    int help() const
+    {
+        std::cout << "Usage: \n   lottieBench [options] [file.json|directory ...]\n\n"
+                     "Options: \n"
+                     "    -s sizes     comma separated surface sizes (default 200,512)\n"
+                     "    -t threads   comma separated counts of frames in flight (default 1,4)\n"
+                     "    -p runs      parse runs per file, the best one is kept (default 3)\n"
+                     "    -b bands     split each frame in up to this many bands (default 1)\n"
+                     "    -f frames    render at most this many frames per file\n"
+                     "    -o file      write the results as csv or json (by extension)\n\n"
+                     "Examples: \n"
+                     "    $ lottieBench\n"
+                     "    $ lottieBench -s 1024 -t 1,2,4,8 -o result.csv example/resource\n\n";
+        return 1;
+    }
+
+private:
+    std::vector<std::string> inputs;
+    std::vector<std::string> files;
+    std::vector<size_t>      sizes{200, 512};
+    std::vector<size_t>      threads{1, 4};
+    std::vector<Result>      results;
+    std::string              output;
+    int                      parseRuns{3};
+    size_t                   bands{1};
+    size_t                   maxFrames{0};
+};
+
+int
+main(int argc, char **argv)
+{
+    Benchmark benchmark;
+
+    if (benchmark.setup(argc, argv)) return 1;
+
+    return benchmark.run();
+}
@@ -0,0 +1,103 @@
+#include <rlottie.h>
+
+#include<iostream>
+#include<string>
+#include<array>
+
+#ifndef _WIN32
+#include<limits.h>
+#include<stdlib.h>
+#else
+#include <windows.h>
+#include <stdlib.h>
+#endif
+
+class App {
+public:
+    int convert()
+    {
+        auto player = rlottie::Animation::loadFromFile(fileName, false);
+        if (!player) return help();
+
+        if (!player->saveToBinary(binName)) {
+            std::cout<<"Failed to write binary file : "<<binName<<std::endl;
+            return 1;
+        }
+
+        // make sure the result loads back.
+        if (!rlottie::Animation::loadFromBinary(binName, false)) {
+            std::cout<<"Failed to load back binary file : "<<binName<<std::endl;
+            return 1;
+        }
+        return result();
+    }
+
+    int setup(int argc, char **argv)
+    {
+        char *path{nullptr};
+
+        if (argc > 1) path = argv[1];
+
+        if (!path) return help();
+
+        std::array<char, 5000> memory;
+
+#ifdef _WIN32
+        path = _fullpath(memory.data(), path, memory.size());
+#else
+        path = realpath(path, memory.data());
+#endif
+        if (!path) return help();
+
+        fileName = std::string(path);
+
+        if (!jsonFile()) return help();
+
+        if (argc > 2) {
+            binName = argv[2];
+        } else {
+            binName = basename(fileName);
+            binName.append(".bin");
+        }
+        return 0;
+    }
+
+private:
+    std::string basename(const std::string &str)
+    {
+        return str.substr(str.find_last_of("/\\") + 1);
+    }
+
+    bool jsonFile() {
+        std::string extn = ".json";
+        if ( fileName.size() <= extn.size() ||
+             fileName.substr(fileName.size()- extn.size()) != extn )
+            return false;
+
+        return true;
+    }
+
+    int result() {
+        std::cout<<"Generated binary file : "<<binName<<std::endl;
+        return 0;
+    }
+
+    int help() {
+        std::cout<<"Usage: \n   lottie2bin [lottieFileName] [binaryFileName]\n\nExamples: \n    $ lottie2bin input.json\n    $ lottie2bin input.json input.bin\n\n";
+        return 1;
+    }
+
+private:
+    std::string fileName;
+    std::string binName;
+};
+
+int
+main(int argc, char **argv)
+{
+    App app;
+
+    if (app.setup(argc, argv)) return 1;
+
+    return app.convert();
+}
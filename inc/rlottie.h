@@ -45,6 +45,38 @@ namespace rlottie {
  */
 LOT_EXPORT void configureModelCacheSize(size_t cacheSize);
 
+/**
+ *  @brief Configures the memory budget of the rlottie model cache.
+ *
+ *  Least recently used models are evicted once the total memory
+ *  footprint of the cached models exceeds the budget, in addition to the
+ *  entry count limit set by configureModelCacheSize().
+ *
+ *  @param[in] bytes  Maximum memory in bytes held by the cached models.
+ *
+ *  @note configure with 0 to remove the memory budget (default).
+ *
+ *  @internal
+ */
+LOT_EXPORT void configureModelCacheBudget(size_t bytes);
+
+struct ModelCacheStats {
+    size_t hits{0};      /*!< lookups served from the cache */
+    size_t misses{0};    /*!< lookups that required a parse */
+    size_t evictions{0}; /*!< models dropped to respect the size or budget */
+    size_t count{0};     /*!< models currently in the cache */
+    size_t size{0};      /*!< memory in bytes held by the cached models */
+};
+
+/**
+ *  @brief Returns the usage counters of the rlottie model cache.
+ *
+ *  @return the current ModelCacheStats snapshot.
+ *
+ *  @internal
+ */
+LOT_EXPORT ModelCacheStats modelCacheStats();
+
 struct Color {
     Color() = default;
     Color(float r, float g , float b):_r(r), _g(g), _b(b){}
@@ -97,6 +129,12 @@ enum class Property {
     TrOpacity      /*!< Transform Opacity property of Layer and Group object , value type is float [ 0 .. 100] */
 };
 
+/**
+ *  @brief Handle of a keypath bound to a property by Animation::bindProperty().
+ *  0 is not a valid handle.
+ */
+using PropertyHandle = size_t;
+
 struct Color_Type{};
 struct Point_Type{};
 struct Size_Type{};
@@ -240,6 +278,16 @@ private:
     bool mNeedClear{true};
 };
 
+/**
+ *  @brief Callback used by Animation::renderRange() to get the Surface
+ *         in which the content of the frame @p frameNo has to be drawn.
+ *
+ *  Returning a Surface without buffer skips the frame.
+ *
+ *  @see Animation::renderRange()
+ */
+using SurfaceProvider = rlottie_std::function<Surface(size_t frameNo)>;
+
 using MarkerList = rlottie_std::vector<rlottie_std::tuple<rlottie_std::string, int , int>>;
 /**
  *  @brief https://helpx.adobe.com/after-effects/using/layer-markers-composition-markers.html
@@ -250,6 +298,23 @@ using MarkerList = rlottie_std::vector<rlottie_std::tuple<rlottie_std::string, i
 
 using LayerInfoList = rlottie_std::vector<rlottie_std::tuple<rlottie_std::string, int , int>>;
 
+/**
+ *  @brief Per stage timing of a single rendered frame.
+ *  The times are in milliseconds and don't overlap, so their sum is the
+ *  time taken by renderSync().
+ *
+ *  @see Animation::renderSync(size_t, Surface, bool, FrameStats *)
+ */
+struct FrameStats {
+    double updateTime{0};       /*!< evaluating the keyframes of the frame */
+    double preprocessTime{0};   /*!< scheduling and waiting for rasterization */
+    double renderTime{0};       /*!< blending the rasterized content */
+    double matteTime{0};        /*!< matte and mask compositing */
+    size_t drawables{0};        /*!< drawables blended into the surface */
+    size_t rleSpans{0};         /*!< rle spans blended into the surface */
+    size_t offscreenBitmaps{0}; /*!< offscreen buffers used for compositing */
+};
+
 class LOT_EXPORT Animation {
 public:
 
@@ -290,6 +355,43 @@ public:
     loadFromData(rlottie_std::string jsonData, const rlottie_std::string &key,
                  const rlottie_std::string &resourcePath="", bool cachePolicy=true);
 
+    /**
+     *  @brief Constructs an animation object from a binary model file.
+     *
+     *  The binary model is produced by saveToBinary() and loads without
+     *  any json parsing. The file is mapped in memory where supported.
+     *
+     *  @param[in] path Binary model file path.
+     *  @param[in] cachePolicy whether to cache or not the model data.
+     *
+     *  @return Animation object that can render the contents of the
+     *          binary model, or nullptr if the file is not a binary model
+     *          written by a compatible version of the library.
+     *
+     *  @see saveToBinary()
+     *
+     *  @internal
+     */
+    static rlottie_std::unique_ptr<Animation>
+    loadFromBinary(const rlottie_std::string &path, bool cachePolicy=true);
+
+    /**
+     *  @brief Saves the parsed model of this animation as a binary model file.
+     *
+     *  @param[in] path Binary model file path.
+     *
+     *  @return true if the file was written.
+     *
+     *  @note The binary model depends on the byte order and the version of
+     *        the library that wrote it; keep the json resource around to
+     *        regenerate it.
+     *
+     *  @see loadFromBinary()
+     *
+     *  @internal
+     */
+    bool saveToBinary(const rlottie_std::string &path) const;
+
     /**
      *  @brief Returns default framerate of the Lottie resource.
      *
@@ -382,10 +484,183 @@ public:
      *  @param[in] surface Surface in which content will be drawn
      *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
      *
+     *  @see dirtyRegion()
      *  @internal
      */
     void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
 
+    /**
+     *  @brief Renders the content to surface synchronously and reports
+     *         where the time of the frame was spent.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *  @param[out] stats filled with the timing and counters of this frame.
+     *
+     *  @note collecting the stats adds a small overhead to the rendering,
+     *        use the other renderSync() when they are not needed.
+     *
+     *  @see FrameStats
+     *  @internal
+     */
+    void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio,
+                                 FrameStats *stats);
+
+    /**
+     *  @brief Renders a range of frames synchronously.
+     *         Frames {frameStart, frameStart + step, ...} which are less than
+     *         @p frameEnd are drawn into the surfaces returned by @p provider.
+     *         The frames are distributed over the render threads, so it is
+     *         faster than calling render() for each frame when the whole
+     *         animation has to be exported (ex: thumbnails, sprite sheets).
+     *
+     *  @param[in] frameStart first frame number to be drawn.
+     *  @param[in] frameEnd   frame number at which the range ends (excluded).
+     *  @param[in] step       distance between two drawn frames.
+     *  @param[in] provider   gives the Surface for each frame of the range.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @note @p provider can be called concurrently from different threads
+     *        and has to return a different buffer for each frame.
+     *
+     *  @see SurfaceProvider
+     *  @internal
+     */
+    void              renderRange(size_t frameStart, size_t frameEnd, size_t step,
+                                  const SurfaceProvider &provider, bool keepAspectRatio=true);
+
+    /**
+     *  @brief Sets the number of frames of this animation that can be
+     *         rendered at the same time.
+     *         By default only one frame is rendered at a time and a render
+     *         request issued while the previous one is in progress is rejected.
+     *         With a higher count each extra in-flight frame is rendered with
+     *         its own copy of the composition tree (all of them share the
+     *         Lottie model), so a single animation can make use of all the
+     *         render threads.
+     *
+     *  @param[in] count maximum number of frames rendered at the same time.
+     *
+     *  @note each extra copy of the composition tree is kept for reuse,
+     *        so higher count costs more memory.
+     *  @note the surfaces of the in-flight frames must not overlap.
+     *
+     *  @see render()
+     *  @see renderSync()
+     *  @internal
+     */
+    void              setMaxConcurrentRender(size_t count);
+
+    /**
+     *  @brief Returns the number of frames of this animation that can be
+     *         rendered at the same time.
+     *
+     *  @return maximum number of in-flight frames, default is 1.
+     *
+     *  @see setMaxConcurrentRender()
+     *  @internal
+     */
+    size_t            maxConcurrentRender() const;
+
+    /**
+     *  @brief Sets the number of horizontal bands a frame can be split into
+     *         by render() and renderSync(). The bands are blended in parallel
+     *         on the render band threads, so a single large frame (e.g 4K)
+     *         makes use of all the cores instead of blending on the calling
+     *         thread.
+     *
+     *  @param[in] count maximum number of bands of a frame, 1 disables it.
+     *
+     *  @note the actual count is limited by the number of cores and by the
+     *        height of the draw region, small frames are not split.
+     *  @note renderRange() already renders frames in parallel and doesn't
+     *        split them.
+     *
+     *  @see maxRenderBands()
+     *  @internal
+     */
+    void              setMaxRenderBands(size_t count);
+
+    /**
+     *  @brief Returns the number of bands a frame can be split into.
+     *
+     *  @return maximum number of bands of a frame, default is 1.
+     *
+     *  @see setMaxRenderBands()
+     *  @internal
+     */
+    size_t            maxRenderBands() const;
+
+    /**
+     *  @brief Sets whether scaled or rotated image layers are sampled with
+     *         bilinear filtering instead of the nearest pixel.
+     *
+     *  @param[in] smooth true to filter the images, it is slower.
+     *
+     *  @see smoothImages()
+     *  @internal
+     */
+    void              setSmoothImages(bool smooth);
+
+    /**
+     *  @brief Returns whether image layers are sampled with bilinear filtering.
+     *
+     *  @return true if the images are filtered, default is false.
+     *
+     *  @see setSmoothImages()
+     *  @internal
+     */
+    bool              smoothImages() const;
+
+    /**
+     *  @brief Lets render() and renderSync() draw only the area of the frame
+     *         that changed since the last frame of the Animation.
+     *
+     *  The buffer of the surface has to hold the last frame rendered by the
+     *  Animation, with the same draw region. Otherwise the whole draw region
+     *  is drawn, like for the first frame or when frames are rendered in
+     *  parallel.
+     *
+     *  The area drawn is always cleared first, whatever
+     *  Surface::isNeedClear() says, the last frame is not a background.
+     *
+     *  @param[in] partial true to draw only the changed area.
+     *
+     *  @see partialUpdate()
+     *  @see dirtyRegion()
+     *  @internal
+     */
+    void              setPartialUpdate(bool partial);
+
+    /**
+     *  @brief Returns true if only the changed area of a frame is drawn.
+     *
+     *  @return true if the partial update is enabled, default is false.
+     *
+     *  @see setPartialUpdate()
+     *  @internal
+     */
+    bool              partialUpdate() const;
+
+    /**
+     *  @brief Gets the area of the surface updated by the last frame
+     *         rendered, no pixel outside of it changed. Useful to upload
+     *         the frame partially.
+     *
+     *  @param[out] x      region area x position.
+     *  @param[out] y      region area y position.
+     *  @param[out] width  region area width.
+     *  @param[out] height region area height.
+     *
+     *  @note without a partial update it is the draw region of the surface.
+     *
+     *  @see setPartialUpdate()
+     *  @internal
+     */
+    void              dirtyRegion(size_t &x, size_t &y, size_t &width,
+                                  size_t &height) const;
+
     /**
      *  @brief Returns root layer of the composition updated with
      *         content of the Lottie resource at frame number @p frameNo.
@@ -445,6 +720,71 @@ public:
         setValue(MapType<rlottie_std::integral_constant<Property, prop>>{}, prop, keypath, value);
     }
 
+    /**
+     *  @brief Sets property value for the specified {@link KeyPath} from a
+     *  function called with @p data on every frame. Unlike a
+     *  rlottie_std::function the function pointer never allocates.
+     *
+     *  @usage
+     *     static rlottie::Color themeColor(const rlottie::FrameInfo &, void *data)
+     *     {
+     *         return static_cast<Theme *>(data)->accent;
+     *     }
+     *     player->setValue<rlottie::Property::FillColor>("**.fill1", themeColor, theme);
+     *
+     *  @internal
+     */
+    template<Property prop, typename Func>
+    void setValue(const rlottie_std::string &keypath, Func func, void *data)
+    {
+        setValue(MapType<rlottie_std::integral_constant<Property, prop>>{}, prop, keypath, func, data);
+    }
+
+    /**
+     *  @brief Resolves the {@link KeyPath} for the property @p prop once and returns
+     *  a handle to it. Setting the value through the handle doesn't match the
+     *  keypath again, use it for values that change often (e.g every frame).
+     *
+     *  @param[in] keypath keypath as accepted by setValue().
+     *  @param[in] prop    property the handle sets.
+     *
+     *  @return handle for setValue(PropertyHandle, AnyValue), 0 on failure.
+     *
+     *  @usage
+     *     auto handle = player->bindProperty("layer1.group1.fill1", rlottie::Property::FillColor);
+     *     player->setValue<rlottie::Property::FillColor>(handle, rlottie::Color(1, 0, 0));
+     *
+     *  @see setValue()
+     *  @internal
+     */
+    PropertyHandle bindProperty(const rlottie_std::string &keypath, Property prop);
+
+    /**
+     *  @brief Sets property value for the keypath bound to @p handle.
+     *  @p prop must be the property the handle was bound to.
+     *
+     *  @see bindProperty()
+     *  @internal
+     */
+    template<Property prop, typename AnyValue>
+    void setValue(PropertyHandle handle, AnyValue value)
+    {
+        setValue(MapType<rlottie_std::integral_constant<Property, prop>>{}, prop, handle, value);
+    }
+
+    /**
+     *  @brief Sets property value for the keypath bound to @p handle from a
+     *  function called with @p data on every frame.
+     *
+     *  @see bindProperty()
+     *  @internal
+     */
+    template<Property prop, typename Func>
+    void setValue(PropertyHandle handle, Func func, void *data)
+    {
+        setValue(MapType<rlottie_std::integral_constant<Property, prop>>{}, prop, handle, func, data);
+    }
+
     /**
      *  @brief default destructor
      *
@@ -462,6 +802,26 @@ private:
     void setValue(Float_Type, Property, const rlottie_std::string &, rlottie_std::function<float(const FrameInfo &)> &&);
     void setValue(Size_Type, Property, const rlottie_std::string &, rlottie_std::function<Size(const FrameInfo &)> &&);
     void setValue(Point_Type, Property, const rlottie_std::string &, rlottie_std::function<Point(const FrameInfo &)> &&);
+
+    void setValue(Color_Type, Property, PropertyHandle, Color);
+    void setValue(Float_Type, Property, PropertyHandle, float);
+    void setValue(Size_Type, Property, PropertyHandle, Size);
+    void setValue(Point_Type, Property, PropertyHandle, Point);
+
+    void setValue(Color_Type, Property, PropertyHandle, rlottie_std::function<Color(const FrameInfo &)> &&);
+    void setValue(Float_Type, Property, PropertyHandle, rlottie_std::function<float(const FrameInfo &)> &&);
+    void setValue(Size_Type, Property, PropertyHandle, rlottie_std::function<Size(const FrameInfo &)> &&);
+    void setValue(Point_Type, Property, PropertyHandle, rlottie_std::function<Point(const FrameInfo &)> &&);
+
+    void setValue(Color_Type, Property, const rlottie_std::string &, Color (*)(const FrameInfo &, void *), void *);
+    void setValue(Float_Type, Property, const rlottie_std::string &, float (*)(const FrameInfo &, void *), void *);
+    void setValue(Size_Type, Property, const rlottie_std::string &, Size (*)(const FrameInfo &, void *), void *);
+    void setValue(Point_Type, Property, const rlottie_std::string &, Point (*)(const FrameInfo &, void *), void *);
+
+    void setValue(Color_Type, Property, PropertyHandle, Color (*)(const FrameInfo &, void *), void *);
+    void setValue(Float_Type, Property, PropertyHandle, float (*)(const FrameInfo &, void *), void *);
+    void setValue(Size_Type, Property, PropertyHandle, Size (*)(const FrameInfo &, void *), void *);
+    void setValue(Point_Type, Property, PropertyHandle, Point (*)(const FrameInfo &, void *), void *);
     /**
      *  @brief default constructor
      *
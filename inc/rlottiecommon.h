@@ -19,7 +19,7 @@
 #ifndef _RLOTTIE_COMMON_H_
 #define _RLOTTIE_COMMON_H_
 
-#include "lottie_expport.h"
+#include "lottie_export.h"
 
 /**
  * @defgroup Lottie_Animation Lottie_Animation
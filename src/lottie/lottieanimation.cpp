@@ -18,8 +18,10 @@
 #include "config.h"
 #include "lottieitem.h"
 #include "lottieloader.h"
+#include "lottieserializer.h"
 #include "lottiemodel.h"
 #include "rlottie.h"
+#include "velapsedtimer.h"
 
 using namespace rlottie;
 
@@ -28,6 +30,16 @@ LOT_EXPORT void rlottie::configureModelCacheSize(size_t cacheSize)
     LottieLoader::configureModelCacheSize(cacheSize);
 }
 
+LOT_EXPORT void rlottie::configureModelCacheBudget(size_t bytes)
+{
+    LottieLoader::configureModelCacheBudget(bytes);
+}
+
+LOT_EXPORT ModelCacheStats rlottie::modelCacheStats()
+{
+    return LottieLoader::modelCacheStats();
+}
+
 struct RenderTask {
     RenderTask() { receiver = sender.get_future(); }
     rlottie_std::promise<Surface> sender;
@@ -36,6 +48,10 @@ struct RenderTask {
     size_t                frameNo{0};
     Surface               surface;
     bool                  keepAspectRatio{true};
+    // frame range rendering (@see AnimationImpl::renderRange)
+    const SurfaceProvider *provider{nullptr};
+    size_t                frameCount{0};
+    size_t                frameStep{1};
 };
 using SharedRenderTask = rlottie_std::shared_ptr<RenderTask>;
 
@@ -48,8 +64,12 @@ public:
     double  frameRate() const { return mModel->frameRate(); }
     size_t  totalFrame() const { return mModel->totalFrame(); }
     size_t  frameAtPos(double pos) const { return mModel->frameAtPos(pos); }
-    Surface render(size_t frameNo, const Surface &surface, bool keepAspectRatio);
+    Surface render(size_t frameNo, const Surface &surface, bool keepAspectRatio,
+                   FrameStats *stats = nullptr);
+    Surface render(const RenderTask &task);
     rlottie_std::future<Surface> renderAsync(size_t frameNo, Surface &&surface, bool keepAspectRatio);
+    void    renderRange(size_t frameStart, size_t frameEnd, size_t step,
+                        const SurfaceProvider &provider, bool keepAspectRatio);
     const LOTLayerNode * renderTree(size_t frameNo, const VSize &size);
 
     const LayerInfoList &layerInfoList() const
@@ -64,21 +84,145 @@ public:
         return mModel->markers();
     }
     void setValue(const rlottie_std::string &keypath, LOTVariant &&value);
+    PropertyHandle bindProperty(const rlottie_std::string &keypath, Property prop);
+    void setValue(PropertyHandle handle, LOTVariant &&value);
     void removeFilter(const rlottie_std::string &keypath, Property prop);
+    bool    saveToBinary(const rlottie_std::string &path) const;
+    void setMaxConcurrentRender(size_t count) { mMaxConcurrentRender = count ? count : 1; }
+    size_t maxConcurrentRender() const { return mMaxConcurrentRender; }
+    void setMaxRenderBands(size_t count) { mMaxRenderBands = count ? count : 1; }
+    size_t maxRenderBands() const { return mMaxRenderBands; }
+    void setSmoothImages(bool smooth) { mSmoothImages = smooth; }
+    bool smoothImages() const { return mSmoothImages; }
+    void setPartialUpdate(bool partial) { mPartialUpdate = partial; }
+    bool partialUpdate() const { return mPartialUpdate; }
+    VRect dirtyRegion() const
+    {
+        rlottie_std::lock_guard<rlottie_std::mutex> guard(mDirtyMutex);
+        return mDirtyRegion;
+    }
 
 private:
+    bool update(LOTCompItem *item, size_t frameNo, const VSize &size, bool keepAspectRatio);
+    void renderFrame(LOTCompItem *item, size_t frameNo, const Surface &surface,
+                     bool keepAspectRatio, FrameStats *stats);
+    void renderFrames(LOTCompItem *item, size_t frameNo, size_t count, size_t step,
+                      const SurfaceProvider &provider, bool keepAspectRatio);
+    rlottie_std::unique_ptr<LOTCompItem> acquireCompItem();
+    void releaseCompItem(rlottie_std::unique_ptr<LOTCompItem> item);
+private:
+    using PropertyValue = rlottie_std::pair<rlottie_std::string, LOTVariant>;
     mutable LayerInfoList        mLayerList;
     rlottie_std::string                  mFilePath;
     rlottie_std::shared_ptr<LOTModel>    mModel;
     rlottie_std::unique_ptr<LOTCompItem> mCompItem;
     SharedRenderTask             mTask;
     rlottie_std::atomic<bool>            mRenderInProgress;
+    rlottie_std::atomic<size_t>          mMaxConcurrentRender{1};
+    rlottie_std::atomic<size_t>          mConcurrentRender{0};
+    rlottie_std::atomic<size_t>          mMaxRenderBands{1};
+    rlottie_std::atomic<bool>            mSmoothImages{false};
+    rlottie_std::atomic<bool>            mPartialUpdate{false};
+    mutable rlottie_std::mutex           mDirtyMutex;
+    VRect                                mDirtyRegion; // of the last frame
+    /*
+     * Frames rendered so far by all the items. A partial update of
+     * mCompItem is only valid when no other item drew a frame since its
+     * last frame (mCompItemFrame).
+     */
+    rlottie_std::atomic<size_t>          mFrameCount{0};
+    size_t                               mCompItemFrame{0};
+    /*
+     * Extra composition items used to render frames of this animation
+     * in parallel (by renderRange() or when the main item is busy and
+     * more than one frame is allowed to be rendered at a time). They share the model with mCompItem and are kept around
+     * for reuse once created. mValues keeps all the property overrides so
+     * that a newly created item can be brought in sync with mCompItem.
+     */
+    rlottie_std::vector<rlottie_std::unique_ptr<LOTCompItem>> mCompItemPool;
+    rlottie_std::vector<PropertyValue>                       mValues;
+    rlottie_std::mutex                                       mPoolMutex;
 };
 
 void AnimationImpl::setValue(const rlottie_std::string &keypath, LOTVariant &&value)
 {
     if (keypath.empty()) return;
     mCompItem->setValue(keypath, value);
+
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mPoolMutex);
+    for (auto &item : mCompItemPool) item->setValue(keypath, value);
+
+    auto search = rlottie_std::find_if(mValues.begin(), mValues.end(),
+                                       [&](const PropertyValue &e) {
+                                           return e.first == keypath &&
+                                                  e.second.property() == value.property();
+                                       });
+    if (search != mValues.end())
+        search->second = rlottie_std::move(value);
+    else
+        mValues.emplace_back(keypath, rlottie_std::move(value));
+}
+
+/*
+ * A handle is the index of its keypath in mValues plus one, every item
+ * keeps the filters the keypath resolved to under the same index.
+ */
+PropertyHandle AnimationImpl::bindProperty(const rlottie_std::string &keypath,
+                                           Property prop)
+{
+    if (keypath.empty()) return 0;
+
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mPoolMutex);
+    auto search = rlottie_std::find_if(mValues.begin(), mValues.end(),
+                                       [&](const PropertyValue &e) {
+                                           return e.first == keypath &&
+                                                  e.second.property() == prop;
+                                       });
+    if (search == mValues.end())
+        search = mValues.emplace(mValues.end(), keypath, LOTVariant(prop));
+
+    size_t binding = size_t(search - mValues.begin());
+    mCompItem->bindProperty(binding, keypath, prop);
+    for (auto &item : mCompItemPool) item->bindProperty(binding, keypath, prop);
+
+    return binding + 1;
+}
+
+void AnimationImpl::setValue(PropertyHandle handle, LOTVariant &&value)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mPoolMutex);
+    if (!handle || handle > mValues.size()) return;
+
+    size_t binding = handle - 1;
+    if (mValues[binding].second.property() != value.property()) return;
+
+    mCompItem->setValue(binding, value);
+    for (auto &item : mCompItemPool) item->setValue(binding, value);
+    mValues[binding].second = rlottie_std::move(value);
+}
+
+rlottie_std::unique_ptr<LOTCompItem> AnimationImpl::acquireCompItem()
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mPoolMutex);
+    if (!mCompItemPool.empty()) {
+        auto item = rlottie_std::move(mCompItemPool.back());
+        mCompItemPool.pop_back();
+        return item;
+    }
+
+    auto item = rlottie_std::make_unique<LOTCompItem>(mModel.get());
+    for (size_t i = 0; i < mValues.size(); i++) {
+        auto &e = mValues[i];
+        item->bindProperty(i, e.first, e.second.property());
+        if (!e.second.empty()) item->setValue(i, e.second);
+    }
+    return item;
+}
+
+void AnimationImpl::releaseCompItem(rlottie_std::unique_ptr<LOTCompItem> item)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mPoolMutex);
+    mCompItemPool.push_back(rlottie_std::move(item));
 }
 
 const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
@@ -90,6 +234,12 @@ const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
 }
 
 bool AnimationImpl::update(size_t frameNo, const VSize &size, bool keepAspectRatio)
+{
+    return update(mCompItem.get(), frameNo, size, keepAspectRatio);
+}
+
+bool AnimationImpl::update(LOTCompItem *item, size_t frameNo, const VSize &size,
+                           bool keepAspectRatio)
 {
     frameNo += mModel->startFrame();
 
@@ -97,26 +247,94 @@ bool AnimationImpl::update(size_t frameNo, const VSize &size, bool keepAspectRat
 
     if (frameNo < mModel->startFrame()) frameNo = mModel->startFrame();
 
-    return mCompItem->update(int(frameNo), size, keepAspectRatio);
+    item->setSmoothImages(mSmoothImages);
+    return item->update(int(frameNo), size, keepAspectRatio);
+}
+
+void AnimationImpl::renderFrame(LOTCompItem *item, size_t frameNo,
+                                const Surface &surface, bool keepAspectRatio,
+                                FrameStats *stats)
+{
+    VSize size(int(surface.drawRegionWidth()), int(surface.drawRegionHeight()));
+
+    size_t frame = ++mFrameCount;
+    bool   partial = false;
+    if (item == mCompItem.get()) {
+        partial = mPartialUpdate && (mCompItemFrame + 1 == frame);
+        mCompItemFrame = frame;
+    }
+
+    if (!stats) {
+        update(item, frameNo, size, keepAspectRatio);
+        item->render(surface, nullptr, mMaxRenderBands, partial);
+    } else {
+        *stats = FrameStats();
+        VElapsedTimer timer;
+        timer.start();
+        update(item, frameNo, size, keepAspectRatio);
+        stats->updateTime = timer.restart();
+        item->render(surface, stats, mMaxRenderBands, partial);
+        // whatever was not accounted to the other stages is blending.
+        stats->renderTime = timer.elapsed() - stats->preprocessTime - stats->matteTime;
+    }
+
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mDirtyMutex);
+    mDirtyRegion = item->dirtyRegion();
 }
 
-Surface AnimationImpl::render(size_t frameNo, const Surface &surface, bool keepAspectRatio)
+Surface AnimationImpl::render(size_t frameNo, const Surface &surface, bool keepAspectRatio,
+                              FrameStats *stats)
 {
-    bool renderInProgress = mRenderInProgress.load();
-    if (renderInProgress) {
+    bool renderInProgress = false;
+    if (mRenderInProgress.compare_exchange_strong(renderInProgress, true)) {
+        renderFrame(mCompItem.get(), frameNo, surface, keepAspectRatio, stats);
+        mRenderInProgress.store(false);
+        return surface;
+    }
+
+    // main item is busy, render the frame using an extra item if allowed.
+    if (mConcurrentRender.fetch_add(1) + 1 >= mMaxConcurrentRender.load()) {
+        mConcurrentRender--;
         vCritical << "Already Rendering Scheduled for this Animation";
         return surface;
     }
 
-    mRenderInProgress.store(true);
-    update(frameNo,
-           VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())), keepAspectRatio);
-    mCompItem->render(surface);
-    mRenderInProgress.store(false);
+    auto item = acquireCompItem();
+    renderFrame(item.get(), frameNo, surface, keepAspectRatio, stats);
+    releaseCompItem(rlottie_std::move(item));
+    mConcurrentRender--;
 
     return surface;
 }
 
+Surface AnimationImpl::render(const RenderTask &task)
+{
+    if (!task.provider)
+        return render(task.frameNo, task.surface, task.keepAspectRatio);
+
+    auto item = acquireCompItem();
+    renderFrames(item.get(), task.frameNo, task.frameCount, task.frameStep,
+                 *task.provider, task.keepAspectRatio);
+    releaseCompItem(rlottie_std::move(item));
+    return {};
+}
+
+void AnimationImpl::renderFrames(LOTCompItem *item, size_t frameNo, size_t count,
+                                 size_t step, const SurfaceProvider &provider,
+                                 bool keepAspectRatio)
+{
+    for (size_t i = 0; i < count; i++, frameNo += step) {
+        Surface surface = provider(frameNo);
+        if (!surface.buffer()) continue;
+
+        mFrameCount++;
+        update(item, frameNo,
+               VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())),
+               keepAspectRatio);
+        item->render(surface);
+    }
+}
+
 void AnimationImpl::init(const rlottie_std::shared_ptr<LOTModel> &model)
 {
     mModel = model;
@@ -124,6 +342,20 @@ void AnimationImpl::init(const rlottie_std::shared_ptr<LOTModel> &model)
     mRenderInProgress = false;
 }
 
+bool AnimationImpl::saveToBinary(const rlottie_std::string &path) const
+{
+    rlottie_std::string blob = LottieSerializer::serialize(*mModel);
+    if (blob.empty()) return false;
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        vCritical << "failed to open file = " << path.c_str();
+        return false;
+    }
+    bool result = fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+    return (fclose(f) == 0) && result;
+}
+
 #ifdef LOTTIE_THREAD_SUPPORT
 
 #include <thread>
@@ -159,8 +391,7 @@ class RenderTaskScheduler {
             }
             if (!success && !_q[i].pop(task)) break;
 
-            auto result =
-                task->playerImpl->render(task->frameNo, task->surface, task->keepAspectRatio);
+            auto result = task->playerImpl->render(*task);
             task->sender.set_value(result);
         }
     }
@@ -186,6 +417,8 @@ public:
         for (auto &e : _threads) e.join();
     }
 
+    unsigned concurrency() const { return _count; }
+
     rlottie_std::future<Surface> process(SharedRenderTask task)
     {
         auto receiver = rlottie_std::move(task->receiver);
@@ -212,9 +445,11 @@ public:
         return singleton;
     }
 
+    unsigned concurrency() const { return 1; }
+
     rlottie_std::future<Surface> process(SharedRenderTask task)
     {
-        auto result = task->playerImpl->render(task->frameNo, task->surface, task->keepAspectRatio);
+        auto result = task->playerImpl->render(*task);
         task->sender.set_value(result);
         return rlottie_std::move(task->receiver);
     }
@@ -225,7 +460,11 @@ rlottie_std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
                                                 Surface &&surface,
                                                 bool keepAspectRatio)
 {
-    if (!mTask) {
+    /*
+     * when frames can be rendered concurrently the previous task may still
+     * be in flight so we can't reuse it.
+     */
+    if (!mTask || mMaxConcurrentRender > 1) {
         mTask = rlottie_std::make_shared<RenderTask>();
     } else {
         mTask->sender = rlottie_std::promise<Surface>();
@@ -239,6 +478,53 @@ rlottie_std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
     return RenderTaskScheduler::instance().process(mTask);
 }
 
+/*
+ * The frame range is split into contiguous chunks, one per worker thread, so
+ * that each composition item mostly sees consecutive frames and can reuse the
+ * work of the previous frame. The first chunk is rendered on the calling
+ * thread using the animation's own item, the rest are scheduled as a single
+ * task per chunk on the render thread pool using extra items from the pool.
+ */
+void AnimationImpl::renderRange(size_t frameStart, size_t frameEnd, size_t step,
+                                const SurfaceProvider &provider, bool keepAspectRatio)
+{
+    if (!step || !provider || frameStart >= frameEnd) return;
+
+    bool renderInProgress = false;
+    if (!mRenderInProgress.compare_exchange_strong(renderInProgress, true)) {
+        vCritical << "Already Rendering Scheduled for this Animation";
+        return;
+    }
+
+    size_t frameCount = (frameEnd - frameStart + step - 1) / step;
+    size_t chunkCount = rlottie_std::min<size_t>(
+        RenderTaskScheduler::instance().concurrency(), frameCount);
+    if (!chunkCount) chunkCount = 1;
+
+    rlottie_std::vector<rlottie_std::future<Surface>> results;
+    results.reserve(chunkCount - 1);
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t first = i * frameCount / chunkCount;
+        size_t last = (i + 1) * frameCount / chunkCount;
+
+        auto task = rlottie_std::make_shared<RenderTask>();
+        task->playerImpl = this;
+        task->frameNo = frameStart + first * step;
+        task->frameCount = last - first;
+        task->frameStep = step;
+        task->provider = &provider;
+        task->keepAspectRatio = keepAspectRatio;
+        results.push_back(RenderTaskScheduler::instance().process(rlottie_std::move(task)));
+    }
+
+    renderFrames(mCompItem.get(), frameStart, frameCount / chunkCount, step,
+                 provider, keepAspectRatio);
+
+    for (auto &result : results) result.wait();
+
+    mRenderInProgress.store(false);
+}
+
 /**
  * \breif Brief abput the Api.
  * Description about the setFilePath Api
@@ -263,6 +549,23 @@ rlottie_std::unique_ptr<Animation> Animation::loadFromData(
     return nullptr;
 }
 
+rlottie_std::unique_ptr<Animation>
+Animation::loadFromBinary(const rlottie_std::string &path, bool cachePolicy)
+{
+    if (path.empty()) {
+        vWarning << "File path is empty";
+        return nullptr;
+    }
+
+    LottieLoader loader;
+    if (loader.loadFromBinary(path, cachePolicy)) {
+        auto animation = rlottie_std::unique_ptr<Animation>(new Animation);
+        animation->d->init(loader.model());
+        return animation;
+    }
+    return nullptr;
+}
+
 rlottie_std::unique_ptr<Animation>
 Animation::loadFromFile(const rlottie_std::string &path, bool cachePolicy)
 {
@@ -280,6 +583,11 @@ Animation::loadFromFile(const rlottie_std::string &path, bool cachePolicy)
     return nullptr;
 }
 
+bool Animation::saveToBinary(const rlottie_std::string &path) const
+{
+    return d->saveToBinary(path);
+}
+
 void Animation::size(size_t &width, size_t &height) const
 {
     VSize sz = d->size();
@@ -324,6 +632,68 @@ void Animation::renderSync(size_t frameNo, Surface surface, bool keepAspectRatio
     d->render(frameNo, surface, keepAspectRatio);
 }
 
+void Animation::renderSync(size_t frameNo, Surface surface, bool keepAspectRatio,
+                           FrameStats *stats)
+{
+    d->render(frameNo, surface, keepAspectRatio, stats);
+}
+
+void Animation::setMaxConcurrentRender(size_t count)
+{
+    d->setMaxConcurrentRender(count);
+}
+
+size_t Animation::maxConcurrentRender() const
+{
+    return d->maxConcurrentRender();
+}
+
+void Animation::setMaxRenderBands(size_t count)
+{
+    d->setMaxRenderBands(count);
+}
+
+size_t Animation::maxRenderBands() const
+{
+    return d->maxRenderBands();
+}
+
+void Animation::setSmoothImages(bool smooth)
+{
+    d->setSmoothImages(smooth);
+}
+
+bool Animation::smoothImages() const
+{
+    return d->smoothImages();
+}
+
+void Animation::setPartialUpdate(bool partial)
+{
+    d->setPartialUpdate(partial);
+}
+
+bool Animation::partialUpdate() const
+{
+    return d->partialUpdate();
+}
+
+void Animation::dirtyRegion(size_t &x, size_t &y, size_t &width,
+                            size_t &height) const
+{
+    VRect region = d->dirtyRegion();
+    x = size_t(region.left());
+    y = size_t(region.top());
+    width = size_t(region.width());
+    height = size_t(region.height());
+}
+
+void Animation::renderRange(size_t frameStart, size_t frameEnd, size_t step,
+                            const SurfaceProvider &provider, bool keepAspectRatio)
+{
+    d->renderRange(frameStart, frameEnd, step, provider, keepAspectRatio);
+}
+
 const LayerInfoList &Animation::layers() const
 {
     return d->layerInfoList();
@@ -337,29 +707,25 @@ const MarkerList &Animation::markers() const
 void Animation::setValue(Color_Type, Property prop, const rlottie_std::string &keypath,
                          Color value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    d->setValue(keypath, LOTVariant(prop, value));
 }
 
 void Animation::setValue(Float_Type, Property prop, const rlottie_std::string &keypath,
                          float value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    d->setValue(keypath, LOTVariant(prop, value));
 }
 
 void Animation::setValue(Size_Type, Property prop, const rlottie_std::string &keypath,
                          Size value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    d->setValue(keypath, LOTVariant(prop, value));
 }
 
 void Animation::setValue(Point_Type, Property prop, const rlottie_std::string &keypath,
                          Point value)
 {
-    d->setValue(keypath,
-                LOTVariant(prop, [value](const FrameInfo &) { return value; }));
+    d->setValue(keypath, LOTVariant(prop, value));
 }
 
 void Animation::setValue(Color_Type, Property prop, const rlottie_std::string &keypath,
@@ -386,6 +752,108 @@ void Animation::setValue(Point_Type, Property prop, const rlottie_std::string &k
     d->setValue(keypath, LOTVariant(prop, value));
 }
 
+PropertyHandle Animation::bindProperty(const rlottie_std::string &keypath,
+                                      Property prop)
+{
+    return d->bindProperty(keypath, prop);
+}
+
+void Animation::setValue(Color_Type, Property prop, PropertyHandle handle,
+                         Color value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Float_Type, Property prop, PropertyHandle handle,
+                         float value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Size_Type, Property prop, PropertyHandle handle,
+                         Size value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Point_Type, Property prop, PropertyHandle handle,
+                         Point value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Color_Type, Property prop, PropertyHandle handle,
+                         rlottie_std::function<Color(const FrameInfo &)> &&value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Float_Type, Property prop, PropertyHandle handle,
+                         rlottie_std::function<float(const FrameInfo &)> &&value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Size_Type, Property prop, PropertyHandle handle,
+                         rlottie_std::function<Size(const FrameInfo &)> &&value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Point_Type, Property prop, PropertyHandle handle,
+                         rlottie_std::function<Point(const FrameInfo &)> &&value)
+{
+    d->setValue(handle, LOTVariant(prop, value));
+}
+
+void Animation::setValue(Color_Type, Property prop, const rlottie_std::string &keypath,
+                         Color (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(keypath, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Float_Type, Property prop, const rlottie_std::string &keypath,
+                         float (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(keypath, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Size_Type, Property prop, const rlottie_std::string &keypath,
+                         Size (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(keypath, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Point_Type, Property prop, const rlottie_std::string &keypath,
+                         Point (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(keypath, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Color_Type, Property prop, PropertyHandle handle,
+                         Color (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(handle, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Float_Type, Property prop, PropertyHandle handle,
+                         float (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(handle, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Size_Type, Property prop, PropertyHandle handle,
+                         Size (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(handle, LOTVariant(prop, func, data));
+}
+
+void Animation::setValue(Point_Type, Property prop, PropertyHandle handle,
+                         Point (*func)(const FrameInfo &, void *), void *data)
+{
+    d->setValue(handle, LOTVariant(prop, func, data));
+}
+
 Animation::~Animation() = default;
 Animation::Animation() : d(rlottie_std::make_unique<AnimationImpl>()) {}
 
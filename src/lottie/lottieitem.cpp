@@ -18,11 +18,20 @@
 
 #include "lottieitem.h"
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include "config.h"
 #include "lottiekeypath.h"
 #include "vbitmap.h"
+#include "velapsedtimer.h"
 #include "vpainter.h"
 #include "vraster.h"
 
+#ifdef LOTTIE_THREAD_SUPPORT
+#include <thread>
+#include "vtaskqueue.h"
+#endif
+
 /* Lottie Layer Rules
  * 1. time stretch is pre calculated and applied to all the properties of the
  * lottilayer model and all its children
@@ -30,6 +39,55 @@
  * AE. which means (start frame > endFrame) 3.
  */
 
+/*
+ * Stats of the frame being rendered on this thread, only set while
+ * LOTCompItem::render() runs on behalf of renderSync() with stats.
+ */
+static thread_local rlottie::FrameStats *mFrameStats = nullptr;
+
+/*
+ * Adds the time spent in its scope to one of the FrameStats stages.
+ */
+class StageTimer {
+public:
+    explicit StageTimer(double rlottie::FrameStats::*stage) : mStage(stage)
+    {
+        if (mFrameStats) mTimer.start();
+    }
+    ~StageTimer()
+    {
+        if (mFrameStats) mFrameStats->*mStage += mTimer.elapsed();
+    }
+
+private:
+    double rlottie::FrameStats::*mStage;
+    VElapsedTimer                mTimer;
+};
+
+static void countOffscreenBitmaps(size_t count)
+{
+    if (mFrameStats) mFrameStats->offscreenBitmaps += count;
+}
+
+/*
+ * Prepares painter to draw into a pooled bitmap, an offscreen copy of
+ * rect (inside the clip of the parent painter). The drawing keeps the
+ * parent's coordinates so the bitmap is later drawn back at rect.
+ */
+static VBitmapPool::Bitmap beginOffscreen(VPainter &painter,
+                                          const VPainter &parent,
+                                          const VRect &rect)
+{
+    VRect region = parent.drawRegion();
+    auto  bitmap = VBitmapPool::instance().acquire(size_t(rect.width()),
+                                                   size_t(rect.height()));
+    painter.begin(&bitmap.bitmap());
+    painter.setDrawRegion(
+        VRect(-rect.left(), -rect.top(), region.width(), region.height()));
+    painter.setClipRect(rect);
+    return bitmap;
+}
+
 static bool transformProp(rlottie::Property prop)
 {
     switch (prop) {
@@ -95,15 +153,47 @@ LOTCompItem::LOTCompItem(LOTModel *model)
     : mCurFrameNo(-1)
 {
     mCompData = model->mRoot.get();
+    mKeyFrameCursors = LOTKeyFrameCursors(mCompData->mKeyFrameCursorCount);
     mRootLayer = createLayerItem(mCompData->mRootLayer, &mAllocator);
     mRootLayer->setComplexContent(false);
     mViewSize = mCompData->size();
 }
 
+void LOTCompItem::setSmoothImages(bool smooth)
+{
+    if (mSmoothImages == smooth) return;
+
+    mSmoothImages = smooth;
+    mRootLayer->setSmoothImages(smooth);
+}
+
 void LOTCompItem::setValue(const rlottie_std::string &keypath, LOTVariant &value)
 {
+    LOTKeyPath    key(keypath);
+    LOTFilterList filters;
+    mRootLayer->resolveKeyPath(key, 0, value.property(), filters);
+    for (auto filter : filters) filter->addValue(value);
+}
+
+/*
+ * Resolves the keypath once, setValue() with the binding only updates the
+ * filters it resolved to.
+ */
+void LOTCompItem::bindProperty(size_t binding, const rlottie_std::string &keypath,
+                               rlottie::Property prop)
+{
+    if (binding >= mBindings.size()) mBindings.resize(binding + 1);
+
     LOTKeyPath key(keypath);
-    mRootLayer->resolveKeyPath(key, 0, value);
+    mBindings[binding].clear();
+    mRootLayer->resolveKeyPath(key, 0, prop, mBindings[binding]);
+}
+
+void LOTCompItem::setValue(size_t binding, LOTVariant &value)
+{
+    if (binding >= mBindings.size()) return;
+
+    for (auto filter : mBindings[binding]) filter->addValue(value);
 }
 
 bool LOTCompItem::update(int frameNo, const VSize &size, bool keepAspectRatio)
@@ -135,32 +225,419 @@ bool LOTCompItem::update(int frameNo, const VSize &size, bool keepAspectRatio)
     } else {
        m.scale(sx, sy);
     }
+    LOTKeyFrameCursors::Scope cursors(&mKeyFrameCursors);
     mRootLayer->update(frameNo, m, 1.0);
     return true;
 }
 
-bool LOTCompItem::render(const rlottie::Surface &surface)
+bool LOTCompItem::render(const rlottie::Surface &surface, rlottie::FrameStats *stats,
+                         size_t bands, bool partial)
 {
+    mFrameStats = stats;
+
     mSurface.reset(reinterpret_cast<uchar *>(surface.buffer()),
                    uint(surface.width()), uint(surface.height()), uint(surface.bytesPerLine()),
                    VBitmap::Format::ARGB32_Premultiplied);
-    mSurface.setNeedClear(surface.isNeedClear());
+    /*
+     * a partial update draws over the last frame, the drawn area is always
+     * cleared so that translucent content doesn't pile up.
+     */
+    mSurface.setNeedClear(surface.isNeedClear() || partial);
 
     /* schedule all preprocess task for this frame at once.
      */
     VRect clip(0, 0, int(surface.drawRegionWidth()), int(surface.drawRegionHeight()));
-    mRootLayer->preprocess(clip);
+    {
+        StageTimer timer(&rlottie::FrameStats::preprocessTime);
+        mRootLayer->preprocess(clip);
+    }
+
+    VRect region(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
+                 int(surface.drawRegionWidth()), int(surface.drawRegionHeight()));
+
+    // part of the draw region that has to be drawn.
+    VRect area = clip;
+    if (partial) {
+        StageTimer timer(&rlottie::FrameStats::preprocessTime);
+        VRect dirty = dirtyArea(surface, region);
+        mDirtyRegion = dirty.translated(region.left(), region.top());
+        /*
+         * gradients and transformed images are evaluated incrementally
+         * from the start of a span, a span clipped on the left would round
+         * a bit differently. Whole rows are drawn so that the frame stays
+         * identical to a full render, the pixels around the dirty rect are
+         * drawn again with the same value.
+         */
+        area = dirty.empty() ? VRect() : VRect(0, dirty.top(), clip.width(), dirty.height());
+    } else {
+        mDirtyTracker.reset();
+        mDirtyRegion = region;
+    }
+    if (area.empty()) {
+        mFrameStats = nullptr;
+        return true;
+    }
+
+    // the rest of the surface keeps the last frame.
+    if (area != clip) {
+        auto   buffer = reinterpret_cast<uchar *>(surface.buffer());
+        size_t bpl = surface.bytesPerLine();
+        for (int y = area.top(); y < area.bottom(); y++) {
+            memset(buffer + size_t(region.top() + y) * bpl + size_t(region.left()) * 4,
+                   0, size_t(area.width()) * 4);
+        }
+        mSurface.setNeedClear(false);
+    }
+
+    // bands thinner than this don't pay for the thread hand off.
+    const size_t minBandHeight = 64;
+    bands = rlottie_std::min(bands, size_t(area.height()) / minBandHeight);
+    if (bands > 1) {
+        renderBands(surface, region, area, bands, stats);
+        mFrameStats = nullptr;
+        return true;
+    }
 
     VPainter painter(&mSurface);
     // set sub surface area for drawing.
-    painter.setDrawRegion(
-        VRect(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()),
-              int(surface.drawRegionWidth()), int(surface.drawRegionHeight())));
+    painter.setDrawRegion(region);
+    if (area != clip) painter.setClipRect(area);
     mRootLayer->render(&painter, {}, {});
     painter.end();
+    mFrameStats = nullptr;
     return true;
 }
 
+/*
+ * Returns the part of the frame (in draw region coordinates) that changed
+ * since the last frame drawn into the same surface. The whole frame is
+ * dirty when the last frame is unknown or was drawn somewhere else.
+ */
+VRect LOTCompItem::dirtyArea(const rlottie::Surface &surface, const VRect &region)
+{
+    Target target;
+    target.buffer = surface.buffer();
+    target.bytesPerLine = surface.bytesPerLine();
+    target.region = region;
+
+    bool known = mDirtyTracker.valid() && mLastTarget.buffer == target.buffer &&
+                 mLastTarget.bytesPerLine == target.bytesPerLine &&
+                 mLastTarget.region == target.region;
+    mLastTarget = target;
+
+    VRect clip(0, 0, region.width(), region.height());
+    mDirtyTracker.begin(clip);
+    mRootLayer->collectDirty(mDirtyTracker);
+    VRect dirty = mDirtyTracker.end();
+
+    return known ? (dirty & clip) : clip;
+}
+
+/*
+ * Draws the rows of band (in draw region coordinates) of the frame.
+ */
+void LOTCompItem::renderBand(const rlottie::Surface &surface, const VRect &region,
+                             const VRect &band, bool needClear)
+{
+    if (needClear) {
+        // whole scanlines, like the clear of the full surface.
+        auto buffer = reinterpret_cast<uchar *>(surface.buffer());
+        memset(buffer + size_t(region.top() + band.top()) * surface.bytesPerLine(),
+               0, size_t(band.height()) * surface.bytesPerLine());
+    }
+
+    VPainter painter(&mSurface);
+    painter.setDrawRegion(region);
+    painter.setClipRect(band);
+    mRootLayer->render(&painter, {}, {});
+    painter.end();
+}
+
+/*
+ * Shared by the threads drawing the bands of a frame. The bands are
+ * claimed one by one by the calling thread and the band tasks, so the
+ * frame completes even when no worker is free to pick up a task (e.g
+ * render() called from a render thread). A task that starts late finds
+ * no band left and returns, that's why the job is reference counted.
+ */
+struct RenderBandJob {
+    rlottie_std::function<void(size_t)>     draw;
+    rlottie_std::vector<rlottie::FrameStats> stats;
+    rlottie::FrameStats                    *callerStats{nullptr};
+    size_t                                  count{0};
+    rlottie_std::atomic<size_t>             next{0};
+    size_t                                  done{0};
+    rlottie_std::mutex                      mutex;
+    rlottie_std::condition_variable         finished;
+
+    void run()
+    {
+        size_t band;
+        while ((band = next++) < count) {
+            mFrameStats = callerStats ? &stats[band] : nullptr;
+            draw(band);
+            {
+                rlottie_std::lock_guard<rlottie_std::mutex> lock(mutex);
+                if (++done < count) continue;
+            }
+            finished.notify_all();
+        }
+        mFrameStats = nullptr;
+    }
+
+    void wait()
+    {
+        rlottie_std::unique_lock<rlottie_std::mutex> lock(mutex);
+        while (done < count) finished.wait(lock);
+    }
+};
+using SharedRenderBandJob = rlottie_std::shared_ptr<RenderBandJob>;
+
+#ifdef LOTTIE_THREAD_SUPPORT
+
+/*
+ * Thread pool for the bands of a frame, a task stealing scheduler like
+ * the RleTaskScheduler. The threads are only created by the first frame
+ * rendered in bands.
+ */
+class RenderBandScheduler {
+    const unsigned                           _count{rlottie_std::thread::hardware_concurrency()};
+    rlottie_std::vector<rlottie_std::thread> _threads;
+    rlottie_std::vector<TaskQueue<SharedRenderBandJob>> _q{_count};
+    rlottie_std::atomic<unsigned>            _index{0};
+
+    void run(unsigned i)
+    {
+        while (true) {
+            bool                success = false;
+            SharedRenderBandJob job;
+            for (unsigned n = 0; n != _count * 2; ++n) {
+                if (_q[(i + n) % _count].try_pop(job)) {
+                    success = true;
+                    break;
+                }
+            }
+            if (!success && !_q[i].pop(job)) break;
+
+            job->run();
+        }
+    }
+
+    RenderBandScheduler()
+    {
+        for (unsigned n = 0; n != _count; ++n) {
+            _threads.emplace_back([&, n] { run(n); });
+        }
+    }
+
+public:
+    static RenderBandScheduler &instance()
+    {
+        static RenderBandScheduler singleton;
+        return singleton;
+    }
+
+    ~RenderBandScheduler()
+    {
+        for (auto &e : _q) e.done();
+
+        for (auto &e : _threads) e.join();
+    }
+
+    unsigned concurrency() const { return _count; }
+
+    void process(SharedRenderBandJob job)
+    {
+        auto i = _index++;
+
+        for (unsigned n = 0; n != _count; ++n) {
+            if (_q[(i + n) % _count].try_push(rlottie_std::move(job))) return;
+        }
+
+        if (_count > 0) {
+            _q[i % _count].push(rlottie_std::move(job));
+        }
+    }
+};
+
+#else
+
+class RenderBandScheduler {
+public:
+    static RenderBandScheduler &instance()
+    {
+        static RenderBandScheduler singleton;
+        return singleton;
+    }
+
+    unsigned concurrency() const { return 1; }
+
+    void process(SharedRenderBandJob) {}
+};
+
+#endif
+
+/*
+ * Splits area of the draw region into count horizontal bands drawn in
+ * parallel. The rasterization was already scheduled by preprocess(), every
+ * band walks the whole layer tree and blends only the spans inside of it.
+ */
+void LOTCompItem::renderBands(const rlottie::Surface &surface, const VRect &region,
+                              const VRect &area, size_t count,
+                              rlottie::FrameStats *stats)
+{
+    auto &scheduler = RenderBandScheduler::instance();
+    count = rlottie_std::min(count, size_t(scheduler.concurrency()) + 1);
+    if (count < 2) count = 1;
+
+    // the bands clear their own scanlines, the rest is cleared here.
+    bool needClear = mSurface.isNeedClear();
+    if (needClear) {
+        auto   buffer = reinterpret_cast<uchar *>(surface.buffer());
+        size_t bpl = surface.bytesPerLine();
+        size_t top = size_t(region.top());
+        size_t bottom = size_t(region.bottom());
+        memset(buffer, 0, top * bpl);
+        memset(buffer + bottom * bpl, 0, (surface.height() - bottom) * bpl);
+        mSurface.setNeedClear(false);
+    }
+
+    auto job = rlottie_std::make_shared<RenderBandJob>();
+    job->count = count;
+    job->callerStats = stats;
+    if (stats) job->stats.resize(count);
+    job->draw = [&](size_t band) {
+        int y1 = area.top() + int(band * size_t(area.height()) / count);
+        int y2 = area.top() + int((band + 1) * size_t(area.height()) / count);
+        renderBand(surface, region, VRect(area.left(), y1, area.width(), y2 - y1),
+                   needClear);
+    };
+
+    for (size_t i = 1; i < count; i++) scheduler.process(job);
+    job->run();
+    job->wait();
+
+    mSurface.setNeedClear(needClear);
+    mFrameStats = stats;
+    if (!stats) return;
+
+    // the stages of the bands overlap, count the slowest band.
+    double preprocessTime = 0, matteTime = 0;
+    for (const auto &band : job->stats) {
+        preprocessTime = rlottie_std::max(preprocessTime, band.preprocessTime);
+        matteTime = rlottie_std::max(matteTime, band.matteTime);
+        stats->drawables += band.drawables;
+        stats->rleSpans += band.rleSpans;
+        stats->offscreenBitmaps += band.offscreenBitmaps;
+    }
+    stats->preprocessTime += preprocessTime;
+    stats->matteTime += matteTime;
+}
+
+template <typename T>
+static void appendState(rlottie_std::string &state, const T &value)
+{
+    state.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void appendState(rlottie_std::string &state, const VMatrix &m)
+{
+    float values[] = {m.m_11(), m.m_12(), m.m_13(), m.m_21(), m.m_22(),
+                      m.m_23(), m.m_tx(), m.m_ty(), m.m_33()};
+    appendState(state, values);
+}
+
+// everything that decides the pixels drawn by brush.
+static void appendState(rlottie_std::string &state, const VBrush &brush)
+{
+    appendState(state, brush.mType);
+    switch (brush.mType) {
+    case VBrush::Type::Solid:
+        appendState(state, brush.mColor);
+        break;
+    case VBrush::Type::LinearGradient:
+    case VBrush::Type::RadialGradient: {
+        const VGradient *gradient = brush.mGradient;
+        appendState(state, gradient->mSpread);
+        appendState(state, gradient->mMode);
+        appendState(state, gradient->mAlpha);
+        for (const auto &stop : gradient->mStops) {
+            appendState(state, stop.first);
+            appendState(state, stop.second);
+        }
+        if (brush.mType == VBrush::Type::LinearGradient)
+            appendState(state, gradient->linear);
+        else
+            appendState(state, gradient->radial);
+        appendState(state, gradient->mMatrix);
+        break;
+    }
+    case VBrush::Type::Texture: {
+        const VTexture *texture = brush.mTexture;
+        appendState(state, texture->mBitmap.data());
+        appendState(state, texture->mAlpha);
+        appendState(state, texture->mSmooth);
+        appendState(state, texture->mMatrix);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LOTDirtyTracker::reset()
+{
+    mInputs.clear();
+    mFrame = 0;
+}
+
+bool LOTDirtyTracker::add(const void *key, const VRect &bbox,
+                          const rlottie_std::string &state)
+{
+    auto &input = mInputs[key];
+    bool  changed = input.frame + 1 != mFrame || input.bbox != bbox ||
+                   input.state != state;
+    if (changed || mForce) {
+        mDirty = mDirty | input.bbox | bbox;
+        input.bbox = bbox;
+        input.state = state;
+    }
+    input.frame = mFrame;
+    return changed;
+}
+
+bool LOTDirtyTracker::add(const void *key, const VRect &bbox, size_t serial)
+{
+    mState.clear();
+    appendState(mState, serial);
+    return add(key, bbox, mState);
+}
+
+void LOTDirtyTracker::add(VDrawable *drawable)
+{
+    mState.clear();
+    appendState(mState, drawable->mRleSerial);
+    appendState(mState, drawable->mBrush);
+    add(drawable, drawable->rle().boundingRect(), mState);
+}
+
+/*
+ * Returns the dirty rect of the frame. The inputs that were not added
+ * this time are gone and their last rect is dirty as well.
+ */
+VRect LOTDirtyTracker::end()
+{
+    for (auto it = mInputs.begin(); it != mInputs.end();) {
+        if (it->second.frame != mFrame) {
+            mDirty = mDirty | it->second.bbox;
+            it = mInputs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return mDirty;
+}
+
 void LOTMaskItem::update(int frameNo, const VMatrix &            parentMatrix,
                          float /*parentAlpha*/, const DirtyFlag &flag)
 {
@@ -206,18 +683,23 @@ void LOTLayerItem::render(VPainter *painter, const VRle &inheritMask,
     if (renderlist.empty()) return;
 
     VRle mask;
-    if (mLayerMask) {
-        mask = mLayerMask->maskRle(painter->clipBoundingRect());
-        if (!inheritMask.empty()) mask = mask & inheritMask;
-        // if resulting mask is empty then return.
-        if (mask.empty()) return;
-    } else {
-        mask = inheritMask;
-    }
+    if (!frameMask(inheritMask, mask)) return;
 
+    VRect clip = painter->clipBoundingRect();
     for (auto &i : renderlist) {
+        VRle rle;
+        {
+            // waits for the rasterization scheduled in preprocess.
+            StageTimer timer(&rlottie::FrameStats::preprocessTime);
+            rle = i->rle();
+        }
+        // nothing of the drawable falls into the clip.
+        if (!rle.boundingRect().intersects(clip)) continue;
         painter->setBrush(i->mBrush);
-        VRle rle = i->rle();
+        if (mFrameStats) {
+            mFrameStats->drawables++;
+            mFrameStats->rleSpans += rle.spanCount();
+        }
         if (matteRle.empty()) {
             if (mask.empty()) {
                 // no mask no matte
@@ -231,7 +713,9 @@ void LOTLayerItem::render(VPainter *painter, const VRle &inheritMask,
             if (!mask.empty()) rle = rle & mask;
 
             if (rle.empty()) continue;
-            if (matteType() == MatteType::AlphaInv) {
+            // matteRle is the coverage of the matte, luma included.
+            if (matteType() == MatteType::AlphaInv ||
+                matteType() == MatteType::LumaInv) {
                 rle = rle - matteRle;
                 painter->drawRle(VPoint(), rle);
             } else {
@@ -242,8 +726,145 @@ void LOTLayerItem::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+/*
+ * Adds the inputs render() would draw with to the tracker.
+ */
+bool LOTLayerItem::buildMask(const VRle &inheritMask, VRle &mask)
+{
+    if (!mLayerMask) {
+        mask = inheritMask;
+        return true;
+    }
+    mask = mLayerMask->maskRle();
+    if (!inheritMask.empty()) mask = mask & inheritMask;
+    // if resulting mask is empty then nothing is drawn.
+    return !mask.empty();
+}
+
+/*
+ * buildMask() by the first band that renders the layer, the inherited
+ * mask is the same for all the bands of a frame. preprocess() starts a
+ * new frame.
+ */
+bool LOTLayerItem::frameMask(const VRle &inheritMask, VRle &mask)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mFrameMutex);
+    if (mFrameMaskDirty) {
+        StageTimer timer(&rlottie::FrameStats::matteTime);
+        mFrameMaskVisible = buildMask(inheritMask, mFrameMask);
+        // compute the lazy bounding rect now, the bands share the rle.
+        if (!mFrameMask.empty()) mFrameMask.boundingRect();
+        mFrameMaskDirty = false;
+    }
+    mask = mFrameMask;
+    return mFrameMaskVisible;
+}
+
+bool LOTLayerItem::frameCoverage(const VRle &inheritMask, bool luma, VRle &result)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mFrameMutex);
+    if (mFrameCoverageDirty) {
+        StageTimer timer(&rlottie::FrameStats::matteTime);
+        mFrameCoverageValid = coverageRle(inheritMask, luma, mFrameCoverage);
+        if (!mFrameCoverage.empty()) mFrameCoverage.boundingRect();
+        mFrameCoverageDirty = false;
+    }
+    result = mFrameCoverage;
+    return mFrameCoverageValid;
+}
+
+void LOTLayerItem::collectDirty(LOTDirtyTracker &tracker)
+{
+    auto renderlist = renderList();
+
+    if (renderlist.empty()) return;
+
+    if (mLayerMask) {
+        VRle mask = mLayerMask->maskRle();
+        tracker.add(mLayerMask.get(), mask.boundingRect(), mLayerMask->mRleSerial);
+        if (mask.empty()) return;
+    }
+
+    for (auto &i : renderlist) tracker.add(i);
+}
+
+VRect LOTLayerItem::contentRect()
+{
+    VRect rect;
+    for (auto &i : renderList()) rect = rect | i->rle().boundingRect();
+
+    if (mLayerMask && !rect.empty())
+        rect = rect & mLayerMask->maskRle().boundingRect();
+
+    return rect;
+}
+
+static void appendSpans(size_t count, const VRle::Span *spans, void *userData)
+{
+    auto list = static_cast<rlottie_std::vector<VRle::Span> *>(userData);
+    list->insert(list->end(), spans, spans + count);
+}
+
+/*
+ * Gives the alpha of what render() draws as a coverage rle, when it only
+ * draws solid colors. For a luma matte the colors must be the same, its
+ * luma then stands for the whole drawn area like VBitmap::updateLuma()
+ * gives for the unpremultiplied pixels.
+ */
+bool LOTLayerItem::coverageRle(const VRle &inheritMask, bool luma, VRle &result)
+{
+    result = VRle();
+    auto renderlist = renderList();
+
+    VColor lumaColor;
+    bool   first = true;
+    for (auto &i : renderlist) {
+        if (i->mBrush.mType != VBrush::Type::Solid) return false;
+        VColor color = i->mBrush.mColor;
+        if (luma) {
+            if (!first && (color.red() != lumaColor.red() ||
+                           color.green() != lumaColor.green() ||
+                           color.blue() != lumaColor.blue()))
+                return false;
+            lumaColor = color;
+        }
+        first = false;
+        if (color.isTransparent()) continue;
+
+        VRle rle = i->rle();
+        if (!color.isOpaque()) rle *= color.alpha();
+        // same as the alpha of the colors drawn one over the other.
+        result = result.empty() ? rle : result + rle;
+    }
+
+    if (result.empty()) return true;
+
+    if (mLayerMask) {
+        VRle mask = mLayerMask->maskRle();
+        if (!inheritMask.empty()) mask = mask & inheritMask;
+        result = result & mask;
+    } else if (!inheritMask.empty()) {
+        result = result & inheritMask;
+    }
+
+    if (luma && !result.empty()) {
+        auto value = uchar(0.299f * lumaColor.red() + 0.587f * lumaColor.green() +
+                           0.114f * lumaColor.blue());
+        rlottie_std::vector<VRle::Span> spans;
+        result.intersect(result.boundingRect(), appendSpans, &spans);
+        for (auto &span : spans) span.coverage = value;
+        result = VRle();
+        if (value) result.addSpan(spans.data(), spans.size());
+    }
+    return true;
+}
+
 void LOTLayerMaskItem::preprocess(const VRect &clip)
 {
+    if (mClip != clip) {
+        mClip = clip;
+        mDirty = true;
+    }
     for (auto &i : mMasks) {
         i.preprocess(clip);
     }
@@ -273,10 +894,63 @@ void LOTLayerMaskItem::update(int frameNo, const VMatrix &parentMatrix,
     mDirty = true;
 }
 
-VRle LOTLayerMaskItem::maskRle(const VRect &clipRect)
+/*
+ * The rle ops merge span lists and allocate a new rle per mask, the
+ * buffer costs the area once. Many masks with many spans (complex or
+ * overlapping shapes) go through the buffer.
+ */
+bool LOTLayerMaskItem::useMaskBuffer(VRect &rect)
+{
+    if (mMasks.size() < 2) return false;
+
+    size_t spans = 0;
+    bool   fromClip = false;
+    rect = VRect();
+    for (auto &i : mMasks) {
+        VRle rle = i.rle();
+        spans += rle.spanCount();
+        switch (i.maskMode()) {
+        case LOTMaskData::Mode::Substarct:
+        case LOTMaskData::Mode::Intersect:
+            fromClip = true;
+            break;
+        default:
+            rect = rect | rle.boundingRect();
+            break;
+        }
+    }
+    if (fromClip) rect = mClip;
+    if (rect.empty()) return false;
+
+    // buffer bytes one span of the rle ops is worth.
+    const size_t spanArea = 256;
+    return size_t(rect.width()) * size_t(rect.height()) <= spans * spanArea;
+}
+
+VRle LOTLayerMaskItem::maskRle()
 {
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
     if (!mDirty) return mRle;
 
+    VRect rect;
+    VRle  rle = useMaskBuffer(rect) ? bufferMaskRle(rect) : opMaskRle();
+
+    if (!rle.empty() && !rle.unique()) {
+        mRle.clone(rle);
+    } else {
+        mRle = rle;
+    }
+    // compute the lazy bounding rect now, the bands share the rle.
+    mRle.boundingRect();
+    mRleSerial++;
+    mDirty = false;
+    return mRle;
+}
+
+VRle LOTLayerMaskItem::opMaskRle()
+{
+    const VRect &clipRect = mClip;
+
     VRle rle;
     for (auto &i : mMasks) {
         switch (i.maskMode()) {
@@ -302,14 +976,49 @@ VRle LOTLayerMaskItem::maskRle(const VRect &clipRect)
             break;
         }
     }
+    return rle;
+}
 
-    if (!rle.empty() && !rle.unique()) {
-        mRle.clone(rle);
-    } else {
-        mRle = rle;
+/*
+ * Same result as opMaskRle(), rect covers every pixel it can give.
+ */
+VRle LOTLayerMaskItem::bufferMaskRle(const VRect &rect)
+{
+    // only an intersect or a subtract can empty a non empty buffer.
+    bool empty = true;
+    bool emptyKnown = true;
+    // the buffer is taken from the bitmap pool and goes back after it.
+    VMaskBuffer buffer;
+    buffer.reset(rect);
+    for (auto &i : mMasks) {
+        VRle rle = i.rle();
+        switch (i.maskMode()) {
+        case LOTMaskData::Mode::Add:
+            buffer.compose(rle, VMaskBuffer::Op::Add);
+            if (!rle.empty()) {
+                empty = false;
+                emptyKnown = true;
+            }
+            break;
+        case LOTMaskData::Mode::Substarct:
+        case LOTMaskData::Mode::Intersect:
+            if (!emptyKnown) empty = buffer.empty();
+            // the rle ops start from the clip when nothing is left.
+            if (empty) buffer.reset(rect, 255);
+            buffer.compose(rle, i.maskMode() == LOTMaskData::Mode::Intersect
+                                     ? VMaskBuffer::Op::Intersect
+                                     : VMaskBuffer::Op::Subtract);
+            emptyKnown = false;
+            break;
+        case LOTMaskData::Mode::Difference:
+            buffer.compose(rle, VMaskBuffer::Op::Difference);
+            emptyKnown = false;
+            break;
+        default:
+            break;
+        }
     }
-    mDirty = false;
-    return mRle;
+    return buffer.toRle();
 }
 
 LOTLayerItem::LOTLayerItem(LOTLayerData *layerData) : mLayerData(layerData)
@@ -319,7 +1028,7 @@ LOTLayerItem::LOTLayerItem(LOTLayerData *layerData) : mLayerData(layerData)
 }
 
 bool LOTLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                  LOTVariant &value)
+                                  rlottie::Property prop, LOTFilterList &filters)
 {
     if (!keyPath.matches(name(), depth)) {
         return false;
@@ -327,7 +1036,7 @@ bool LOTLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
 
     if (!keyPath.skip(name())) {
         if (keyPath.fullyResolvesTo(name(), depth) &&
-            transformProp(value.property())) {
+            transformProp(prop)) {
             //@TODO handle propery update.
         }
     }
@@ -335,12 +1044,14 @@ bool LOTLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
 }
 
 bool LOTShapeLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                       LOTVariant &value)
+                                       rlottie::Property prop, LOTFilterList &filters)
 {
-    if (LOTLayerItem::resolveKeyPath(keyPath, depth, value)) {
+    if (LOTLayerItem::resolveKeyPath(keyPath, depth, prop, filters)) {
         if (keyPath.propagate(name(), depth)) {
-            uint newDepth = keyPath.nextDepth(name(), depth);
-            mRoot->resolveKeyPath(keyPath, newDepth, value);
+            uint   newDepth = keyPath.nextDepth(name(), depth);
+            size_t count = filters.size();
+            mRoot->resolveKeyPath(keyPath, newDepth, prop, filters);
+            if (filters.size() > count) mDynamicContent = true;
         }
         return true;
     }
@@ -348,13 +1059,13 @@ bool LOTShapeLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
 }
 
 bool LOTCompLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                      LOTVariant &value)
+                                      rlottie::Property prop, LOTFilterList &filters)
 {
-    if (LOTLayerItem::resolveKeyPath(keyPath, depth, value)) {
+    if (LOTLayerItem::resolveKeyPath(keyPath, depth, prop, filters)) {
         if (keyPath.propagate(name(), depth)) {
             uint newDepth = keyPath.nextDepth(name(), depth);
             for (const auto &layer : mLayers) {
-                layer->resolveKeyPath(keyPath, newDepth, value);
+                layer->resolveKeyPath(keyPath, newDepth, prop, filters);
             }
         }
         return true;
@@ -362,6 +1073,11 @@ bool LOTCompLayerItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
     return false;
 }
 
+void LOTCompLayerItem::setSmoothImages(bool smooth)
+{
+    for (const auto &layer : mLayers) layer->setSmoothImages(smooth);
+}
+
 void LOTLayerItem::update(int frameNumber, const VMatrix &parentMatrix,
                           float parentAlpha)
 {
@@ -396,13 +1112,15 @@ void LOTLayerItem::update(int frameNumber, const VMatrix &parentMatrix,
                            mDirtyFlag);
     }
 
-    // 5. if no parent property change and layer is static then nothing to do.
+    // 5. if no parent property change and layer content didn't change
+    // since its last update then nothing to do.
     if (!mLayerData->precompLayer() && flag().testFlag(DirtyFlagBit::None) &&
-        isStatic())
+        (isStatic() || !contentChanged()))
         return;
 
     // 6. update the content of the layer
     updateContent();
+    mContentFrameNo = frameNo();
 
     // 7. reset the dirty flag
     mDirtyFlag = DirtyFlagBit::None;
@@ -423,6 +1141,12 @@ bool LOTLayerItem::visible() const
 
 void LOTLayerItem::preprocess(const VRect& clip)
 {
+    // a new frame, the rles of the last one are released.
+    mFrameMask = VRle();
+    mFrameCoverage = VRle();
+    mFrameMaskDirty = true;
+    mFrameCoverageDirty = true;
+
     // layer dosen't contribute to the frame
     if (skipRendering()) return;
 
@@ -475,37 +1199,111 @@ void LOTCompLayerItem::render(VPainter *painter, const VRle &inheritMask,
         renderHelper(painter, inheritMask, matteRle);
     } else {
         if (complexContent()) {
-            VSize    size = painter->clipBoundingRect().size();
+            VRect rect = painter->clipBoundingRect() & contentRect();
+            if (rect.empty()) return;
             VPainter srcPainter;
-            VBitmap  srcBitmap(size.width(), size.height(),
-                              VBitmap::Format::ARGB32_Premultiplied);
-            srcPainter.begin(&srcBitmap);
+            countOffscreenBitmaps(1);
+            auto srcBitmap = beginOffscreen(srcPainter, *painter, rect);
             renderHelper(&srcPainter, inheritMask, matteRle);
             srcPainter.end();
-            painter->drawBitmap(VPoint(), srcBitmap, uchar(combinedAlpha() * 255.0f));
+            painter->drawBitmap(VPoint(rect.left(), rect.top()),
+                                srcBitmap.bitmap(),
+                                uchar(combinedAlpha() * 255.0f));
         } else {
             renderHelper(painter, inheritMask, matteRle);
         }
     }
 }
 
-void LOTCompLayerItem::renderHelper(VPainter *painter, const VRle &inheritMask,
-                                    const VRle &matteRle)
+void LOTCompLayerItem::collectDirty(LOTDirtyTracker &tracker)
+{
+    if (vIsZero(combinedAlpha())) return;
+
+    // the children of a complex content don't see the alpha of the layer,
+    // it applies to the whole offscreen. The offscreen is blended over its
+    // whole rect, which can touch the pixels around the children too.
+    float alpha = 1;
+    VRect bbox;
+    if (!vCompare(combinedAlpha(), 1.0) && complexContent()) {
+        alpha = combinedAlpha();
+        bbox = tracker.clip() & contentRect();
+    }
+    rlottie_std::string state;
+    appendState(state, alpha);
+
+    tracker.beginGroup(tracker.add(this, bbox, state));
+    collectDirtyHelper(tracker);
+    tracker.endGroup();
+}
+
+VRect LOTCompLayerItem::contentRect()
+{
+    if (vIsZero(combinedAlpha())) return {};
+
+    // mattes and their layers together, the matte can only shrink it.
+    VRect rect;
+    for (const auto &layer : mLayers) {
+        if (layer->visible()) rect = rect | layer->contentRect();
+    }
+
+    if (mLayerMask && !rect.empty())
+        rect = rect & mLayerMask->maskRle().boundingRect();
+    if (mClipper && !rect.empty())
+        rect = rect & mClipper->mRasterizer.rle().boundingRect();
+
+    return rect;
+}
+
+void LOTCompLayerItem::collectDirtyHelper(LOTDirtyTracker &tracker)
 {
-    VRle mask;
     if (mLayerMask) {
-        mask = mLayerMask->maskRle(painter->clipBoundingRect());
-        if (!inheritMask.empty()) mask = mask & inheritMask;
-        // if resulting mask is empty then return.
+        VRle mask = mLayerMask->maskRle();
+        tracker.add(mLayerMask.get(), mask.boundingRect(), mLayerMask->mRleSerial);
         if (mask.empty()) return;
-    } else {
-        mask = inheritMask;
     }
 
+    if (mClipper) {
+        VRle clip = mClipper->mRasterizer.rle();
+        tracker.add(mClipper.get(), clip.boundingRect(), mClipper->mRleSerial);
+        if (clip.empty()) return;
+    }
+
+    LOTLayerItem *matte = nullptr;
+    for (const auto &layer : mLayers) {
+        if (layer->hasMatte()) {
+            matte = layer;
+        } else {
+            if (layer->visible()) {
+                if (matte) {
+                    if (matte->visible()) {
+                        matte->collectDirty(tracker);
+                        layer->collectDirty(tracker);
+                    }
+                } else {
+                    layer->collectDirty(tracker);
+                }
+            }
+            matte = nullptr;
+        }
+    }
+}
+
+bool LOTCompLayerItem::buildMask(const VRle &inheritMask, VRle &mask)
+{
+    if (!LOTLayerItem::buildMask(inheritMask, mask)) return false;
+
     if (mClipper) {
         mask = mClipper->rle(mask);
-        if (mask.empty()) return;
+        if (mask.empty()) return false;
     }
+    return true;
+}
+
+void LOTCompLayerItem::renderHelper(VPainter *painter, const VRle &inheritMask,
+                                    const VRle &matteRle)
+{
+    VRle mask;
+    if (!frameMask(inheritMask, mask)) return;
 
     LOTLayerItem *matte = nullptr;
     for (const auto &layer : mLayers) {
@@ -530,23 +1328,46 @@ void LOTCompLayerItem::renderMatteLayer(VPainter *painter, const VRle &mask,
                                         const VRle &  matteRle,
                                         LOTLayerItem *layer, LOTLayerItem *src)
 {
-    VSize size = painter->clipBoundingRect().size();
-    // Decide if we can use fast matte.
+    // the result is inside the layer, and inside the matte unless the
+    // matte is inverted. The buffers only cover that part of the clip.
+    VRect rect = painter->clipBoundingRect() & layer->contentRect();
+    if (layer->matteType() == MatteType::Alpha ||
+        layer->matteType() == MatteType::Luma)
+        rect = rect & src->contentRect();
+    if (rect.empty()) return;
+
+    // a matte of solid colors is just a coverage, no matte buffer needed.
+    VRle coverage;
+    if (matteRle.empty() &&
+        src->frameCoverage(mask, layer->matteType() == MatteType::Luma ||
+                                     layer->matteType() == MatteType::LumaInv,
+                           coverage)) {
+        renderCoverageMatte(painter, mask, coverage, rect, layer);
+        return;
+    }
+
     // 1. draw src layer to matte buffer
-    VPainter srcPainter;
-    src->bitmap().reset(size.width(), size.height(),
-                        VBitmap::Format::ARGB32_Premultiplied);
-    srcPainter.begin(&src->bitmap());
+    VPainter            srcPainter;
+    VBitmapPool::Bitmap srcBitmap;
+    {
+        StageTimer timer(&rlottie::FrameStats::matteTime);
+        srcBitmap = beginOffscreen(srcPainter, *painter, rect);
+    }
     src->render(&srcPainter, mask, matteRle);
     srcPainter.end();
 
     // 2. draw layer to layer buffer
-    VPainter layerPainter;
-    layer->bitmap().reset(size.width(), size.height(),
-                          VBitmap::Format::ARGB32_Premultiplied);
-    layerPainter.begin(&layer->bitmap());
+    VPainter            layerPainter;
+    VBitmapPool::Bitmap layerBitmap;
+    {
+        StageTimer timer(&rlottie::FrameStats::matteTime);
+        layerBitmap = beginOffscreen(layerPainter, *painter, rect);
+    }
     layer->render(&layerPainter, mask, matteRle);
 
+    StageTimer timer(&rlottie::FrameStats::matteTime);
+    countOffscreenBitmaps(2);
+
     // 2.1update composition mode
     switch (layer->matteType()) {
     case MatteType::Alpha:
@@ -566,14 +1387,62 @@ void LOTCompLayerItem::renderMatteLayer(VPainter *painter, const VRle &mask,
     // 2.2 update srcBuffer if the matte is luma type
     if (layer->matteType() == MatteType::Luma ||
         layer->matteType() == MatteType::LumaInv) {
-        src->bitmap().updateLuma();
+        srcBitmap.bitmap().updateLuma();
     }
 
     // 2.3 draw src buffer as mask
-    layerPainter.drawBitmap(VPoint(), src->bitmap());
+    layerPainter.drawBitmap(VPoint(rect.left(), rect.top()), srcBitmap.bitmap());
     layerPainter.end();
     // 3. draw the result buffer into painter
-    painter->drawBitmap(VPoint(), layer->bitmap());
+    painter->drawBitmap(VPoint(rect.left(), rect.top()), layerBitmap.bitmap());
+}
+
+/*
+ * Draws layer through the coverage of its matte. A single drawable can't
+ * overlap itself, so it's drawn straight with the matte as a clip. Other
+ * layers are drawn to a buffer first, drawing each of their drawables
+ * through the matte would blend the overlapping ones twice with the
+ * matte edges.
+ */
+void LOTCompLayerItem::renderCoverageMatte(VPainter *painter,
+                                           const VRle &inheritMask,
+                                           const VRle &coverage,
+                                           const VRect &rect,
+                                           LOTLayerItem *layer)
+{
+    bool inverted = layer->matteType() == MatteType::AlphaInv ||
+                    layer->matteType() == MatteType::LumaInv;
+    if (coverage.empty()) {
+        if (inverted) layer->render(painter, inheritMask, {});
+        return;
+    }
+
+    if (layer->renderList().size() == 1) {
+        layer->render(painter, inheritMask, coverage);
+        return;
+    }
+
+    VRect area = inverted ? rect : rect & coverage.boundingRect();
+    if (area.empty()) return;
+
+    VPainter            layerPainter;
+    VBitmapPool::Bitmap layerBitmap;
+    {
+        StageTimer timer(&rlottie::FrameStats::matteTime);
+        layerBitmap = beginOffscreen(layerPainter, *painter, area);
+    }
+    layer->render(&layerPainter, inheritMask, {});
+    layerPainter.end();
+
+    StageTimer timer(&rlottie::FrameStats::matteTime);
+    countOffscreenBitmaps(1);
+
+    VTexture texture;
+    texture.mBitmap = layerBitmap.bitmap();
+    texture.mMatrix.translate(float(area.left()), float(area.top()));
+    painter->setBrush(VBrush(&texture));
+    painter->drawRle(VPoint(),
+                     inverted ? VRle::toRle(area) - coverage : coverage);
 }
 
 void LOTClipperItem::update(const VMatrix &matrix)
@@ -586,8 +1455,10 @@ void LOTClipperItem::update(const VMatrix &matrix)
 
 void LOTClipperItem::preprocess(const VRect &clip)
 {
-    if (mRasterRequest)
+    if (mRasterRequest) {
         mRasterizer.rasterize(mPath, FillRule::Winding, clip);
+        mRleSerial++;
+    }
 
     mRasterRequest = false;
 }
@@ -597,9 +1468,7 @@ VRle LOTClipperItem::rle(const VRle& mask)
     if (mask.empty())
         return mRasterizer.rle();
 
-    mMaskedRle.clone(mask);
-    mMaskedRle &= mRasterizer.rle();
-    return mMaskedRle;
+    return mask & mRasterizer.rle();
 }
 
 void LOTCompLayerItem::updateContent()
@@ -685,7 +1554,6 @@ LOTImageLayerItem::LOTImageLayerItem(LOTLayerData *layerData)
 
     if (!mLayerData->asset()) return;
 
-    mTexture.mBitmap = mLayerData->asset()->bitmap();
     VBrush brush(&mTexture);
     mRenderNode.setBrush(brush);
 }
@@ -694,6 +1562,13 @@ void LOTImageLayerItem::updateContent()
 {
     if (!mLayerData->asset()) return;
 
+    // decode the image only once the layer becomes visible.
+    if (!mTexture.mBitmap.valid()) {
+        mTexture.mBitmap = mLayerData->asset()->bitmap();
+        // an opaque image is copied instead of blended.
+        mTexture.mOpaque = mLayerData->asset()->opaque();
+    }
+
     if (flag() & DirtyFlagBit::Matrix) {
         VPath path;
         path.addRect(VRectF(0, 0, mLayerData->asset()->mWidth,
@@ -793,22 +1668,95 @@ LOTShapeLayerItem::LOTShapeLayerItem(LOTLayerData *layerData, VArenaAlloc* alloc
     if (layerData->hasPathOperator()) {
         list.clear();
         mRoot->processTrimItems(list);
+        mRoot->trimItems(mTrimItems);
     }
+
+    // flatten the content tree so that update and render are linear scans.
+    mContentNodes.push_back({mRoot, ContentType::Group, 0, 0});
+    mRoot->flatten(0, mContentNodes);
+    mContentNodes[0].next = uint32_t(mContentNodes.size());
+    mContentState.resize(mContentNodes.size());
+    mRoot->flattenRender(mRenderNodes);
 }
 
 void LOTShapeLayerItem::updateContent()
 {
-    mRoot->update(frameNo(), combinedMatrix(), combinedAlpha(), flag());
+    int frame = frameNo();
+
+    if (mRoot->updateTransform(frame, combinedMatrix(), combinedAlpha(), flag(),
+                               mContentState[0])) {
+        for (size_t i = 1; i < mContentNodes.size();) {
+            const LOTContentNode & node = mContentNodes[i];
+            const LOTContentState &state = mContentState[node.parent];
 
-    if (mLayerData->hasPathOperator()) {
-        mRoot->applyTrim();
+            switch (node.type) {
+            case ContentType::Group: {
+                auto group = static_cast<LOTContentGroupItem *>(node.item);
+                if (!group->updateTransform(frame, *state.matrix, state.alpha,
+                                            state.flag, mContentState[i])) {
+                    i = node.next;
+                    continue;
+                }
+                break;
+            }
+            case ContentType::Path:
+                static_cast<LOTPathDataItem *>(node.item)
+                    ->update(frame, *state.matrix, state.alpha, state.flag);
+                break;
+            case ContentType::Paint: {
+                auto paint = static_cast<LOTPaintDataItem *>(node.item);
+                bool visible = paint->hasContent();
+                paint->update(frame, *state.matrix, state.alpha, state.flag);
+                if (visible != paint->hasContent()) mRenderListDirty = true;
+                break;
+            }
+            case ContentType::Trim:
+                static_cast<LOTTrimItem *>(node.item)
+                    ->update(frame, *state.matrix, state.alpha, state.flag);
+                break;
+            default:
+                // repeater copies don't share a transform, they are
+                // updated as one node.
+                node.item->update(frame, *state.matrix, state.alpha,
+                                  state.flag);
+                mRenderListDirty = true;
+                break;
+            }
+            ++i;
+        }
     }
+
+    for (auto trim : mTrimItems) trim->update();
+
+    mContentUpdated = true;
 }
 
 void LOTShapeLayerItem::preprocessStage(const VRect& clip)
 {
-    mDrawableList.clear();
-    mRoot->renderList(mDrawableList);
+    // the render nodes only change after an update of the content and the
+    // list only when the visibility of some content changed, otherwise
+    // the list of the last frame is reused.
+    if (mContentUpdated || mRenderListDirty) {
+        if (mRenderListDirty) mDrawableList.clear();
+
+        for (size_t i = 0; i < mRenderNodes.size();) {
+            const LOTContentNode &node = mRenderNodes[i];
+            if (node.type == ContentType::Repeater) {
+                if (static_cast<LOTRepeaterItem *>(node.item)->hidden()) {
+                    i = node.next;
+                    continue;
+                }
+            } else {
+                auto drawable =
+                    static_cast<LOTPaintDataItem *>(node.item)->renderNode();
+                if (mRenderListDirty && drawable)
+                    mDrawableList.push_back(drawable);
+            }
+            ++i;
+        }
+        mContentUpdated = false;
+        mRenderListDirty = false;
+    }
 
     for (auto &drawable : mDrawableList) drawable->preprocess(clip);
 
@@ -818,17 +1766,16 @@ DrawableList LOTShapeLayerItem::renderList()
 {
     if (skipRendering()) return {};
 
-    mDrawableList.clear();
-    mRoot->renderList(mDrawableList);
-
+    // the list is collected by preprocessStage() for this frame.
     if (mDrawableList.empty()) return {};
 
     return {mDrawableList.data() , mDrawableList.size()};
 }
 
 bool LOTContentGroupItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                         LOTVariant &value)
+                                         rlottie::Property prop, LOTFilterList &filters)
 {
+   size_t count = filters.size();
    if (!keyPath.skip(name())) {
         if (!keyPath.matches(mModel.name(), depth)) {
              return false;
@@ -836,8 +1783,8 @@ bool LOTContentGroupItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
 
         if (!keyPath.skip(mModel.name())) {
              if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-                 transformProp(value.property())) {
-                  mModel.filter().addValue(value);
+                 transformProp(prop)) {
+                  filters.push_back(&mModel.filter());
              }
         }
    }
@@ -845,37 +1792,39 @@ bool LOTContentGroupItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
     if (keyPath.propagate(name(), depth)) {
         uint newDepth = keyPath.nextDepth(name(), depth);
         for (auto &child : mContents) {
-            child->resolveKeyPath(keyPath, newDepth, value);
+            child->resolveKeyPath(keyPath, newDepth, prop, filters);
         }
     }
+    // an override in the subtree may change it on any frame.
+    if (filters.size() > count) mDynamicContent = true;
     return true;
 }
 
 bool LOTFillItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                 LOTVariant &value)
+                                 rlottie::Property prop, LOTFilterList &filters)
 {
     if (!keyPath.matches(mModel.name(), depth)) {
         return false;
     }
 
     if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        fillProp(value.property())) {
-        mModel.filter().addValue(value);
+        fillProp(prop)) {
+        filters.push_back(&mModel.filter());
         return true;
     }
     return false;
 }
 
 bool LOTStrokeItem::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                   LOTVariant &value)
+                                   rlottie::Property prop, LOTFilterList &filters)
 {
     if (!keyPath.matches(mModel.name(), depth)) {
         return false;
     }
 
     if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        strokeProp(value.property())) {
-        mModel.filter().addValue(value);
+        strokeProp(prop)) {
+        filters.push_back(&mModel.filter());
         return true;
     }
     return false;
@@ -907,6 +1856,32 @@ void LOTContentGroupItem::addChildren(LOTGroupData *data, VArenaAlloc* allocator
 void LOTContentGroupItem::update(int frameNo, const VMatrix &parentMatrix,
                                  float parentAlpha, const DirtyFlag &flag)
 {
+    LOTContentState state;
+
+    if (!updateTransform(frameNo, parentMatrix, parentAlpha, flag, state))
+        return;
+
+    for (const auto &content : mContents) {
+        content->update(frameNo, matrix(), state.alpha, state.flag);
+    }
+}
+
+/*
+ * Updates the matrix and alpha of the group and fills the state its
+ * children are updated with. Returns false if neither the parent nor the
+ * subtree changed since the last update, the drawables keep their path
+ * and rle then.
+ */
+bool LOTContentGroupItem::updateTransform(int frameNo,
+                                          const VMatrix &  parentMatrix,
+                                          float            parentAlpha,
+                                          const DirtyFlag &flag,
+                                          LOTContentState &state)
+{
+    if (flag.testFlag(DirtyFlagBit::None) && !contentChanged(frameNo))
+        return false;
+    mFrameNo = frameNo;
+
     DirtyFlag newFlag = flag;
     float alpha;
 
@@ -930,22 +1905,53 @@ void LOTContentGroupItem::update(int frameNo, const VMatrix &parentMatrix,
         alpha = parentAlpha;
     }
 
+    state.matrix = &mMatrix;
+    state.alpha = alpha;
+    state.flag = newFlag;
+    return true;
+}
+
+/*
+ * Appends the content of the group in update order, index is the node
+ * of this group. Repeaters are kept as a single node.
+ */
+void LOTContentGroupItem::flatten(uint32_t                           index,
+                                  rlottie_std::vector<LOTContentNode> &nodes)
+{
     for (const auto &content : mContents) {
-        content->update(frameNo, matrix(), alpha, newFlag);
+        auto i = uint32_t(nodes.size());
+        nodes.push_back({content, content->type(), index, i + 1});
+
+        if (content->type() == ContentType::Group) {
+            static_cast<LOTContentGroupItem *>(content)->flatten(i, nodes);
+            nodes[i].next = uint32_t(nodes.size());
+        }
     }
 }
 
-void LOTContentGroupItem::applyTrim()
+/*
+ * Appends the paint items of the group in render order. A repeater node
+ * is followed by the paint items of its copies, next skips all of them.
+ */
+void LOTContentGroupItem::flattenRender(
+    rlottie_std::vector<LOTContentNode> &nodes)
 {
-    for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
-        auto content = (*i);
+    for (const auto &content : mContents) {
         switch (content->type()) {
-        case ContentType::Trim: {
-            static_cast<LOTTrimItem *>(content)->update();
+        case ContentType::Paint: {
+            auto i = uint32_t(nodes.size());
+            nodes.push_back({content, ContentType::Paint, 0, i + 1});
+            break;
+        }
+        case ContentType::Repeater: {
+            auto i = uint32_t(nodes.size());
+            nodes.push_back({content, ContentType::Repeater, 0, i + 1});
+            static_cast<LOTContentGroupItem *>(content)->flattenRender(nodes);
+            nodes[i].next = uint32_t(nodes.size());
             break;
         }
         case ContentType::Group: {
-            static_cast<LOTContentGroupItem *>(content)->applyTrim();
+            static_cast<LOTContentGroupItem *>(content)->flattenRender(nodes);
             break;
         }
         default:
@@ -954,10 +1960,23 @@ void LOTContentGroupItem::applyTrim()
     }
 }
 
-void LOTContentGroupItem::renderList(rlottie_std::vector<VDrawable *> &list)
+void LOTContentGroupItem::trimItems(rlottie_std::vector<LOTTrimItem *> &list)
 {
-    for (const auto &content : mContents) {
-        content->renderList(list);
+    for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
+        auto content = (*i);
+        switch (content->type()) {
+        case ContentType::Trim: {
+            list.push_back(static_cast<LOTTrimItem *>(content));
+            break;
+        }
+        case ContentType::Group:
+        case ContentType::Repeater: {
+            static_cast<LOTContentGroupItem *>(content)->trimItems(list);
+            break;
+        }
+        default:
+            break;
+        }
     }
 }
 
@@ -979,7 +1998,8 @@ void LOTContentGroupItem::processPaintItems(
                                                                    curOpCount);
             break;
         }
-        case ContentType::Group: {
+        case ContentType::Group:
+        case ContentType::Repeater: {
             static_cast<LOTContentGroupItem *>(content)->processPaintItems(
                 list);
             break;
@@ -992,6 +2012,10 @@ void LOTContentGroupItem::processPaintItems(
 
 void LOTContentGroupItem::processTrimItems(rlottie_std::vector<LOTPathDataItem *> &list)
 {
+    // a trim item of a parent group can update the paths of this group
+    // without this group being updated, so don't skip its updates.
+    mPathOperator = true;
+
     size_t curOpCount = list.size();
     for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
         auto content = (*i);
@@ -1005,7 +2029,8 @@ void LOTContentGroupItem::processTrimItems(rlottie_std::vector<LOTPathDataItem *
             static_cast<LOTTrimItem *>(content)->addPathItems(list, curOpCount);
             break;
         }
-        case ContentType::Group: {
+        case ContentType::Group:
+        case ContentType::Repeater: {
             static_cast<LOTContentGroupItem *>(content)->processTrimItems(list);
             break;
         }
@@ -1174,7 +2199,7 @@ void LOTPaintDataItem::updateRenderNode()
     }
 }
 
-void LOTPaintDataItem::renderList(rlottie_std::vector<VDrawable *> &list)
+VDrawable *LOTPaintDataItem::renderNode()
 {
     if (mRenderNodeUpdate) {
         updateRenderNode();
@@ -1189,7 +2214,7 @@ void LOTPaintDataItem::renderList(rlottie_std::vector<VDrawable *> &list)
     // in the subsequent frame when we have content to render but
     // we may not able to update our final path properly as we
     // don't know what paths got changed in between.
-    if (mContentToRender) list.push_back(&mDrawable);
+    return mContentToRender ? &mDrawable : nullptr;
 }
 
 void LOTPaintDataItem::addPathItems(rlottie_std::vector<LOTPathDataItem *> &list,
@@ -1349,32 +2374,32 @@ void LOTTrimItem::update()
     }
 
     if (mData->type() == LOTTrimData::TrimType::Simultaneously) {
-        for (auto &i : mPathItems) {
-            mPathMesure.setRange(mCache.mSegment.start, mCache.mSegment.end);
-            i->updatePath(mPathMesure.trim(i->localPath()));
+        for (size_t i = 0; i < mPathItems.size(); i++) {
+            mPathItems[i]->updatePath(
+                trimPath(i, mCache.mSegment.start, mCache.mSegment.end));
         }
     } else {  // LOTTrimData::TrimType::Individually
         float totalLength = 0.0;
-        for (auto &i : mPathItems) {
-            totalLength += i->localPath().length();
+        for (size_t i = 0; i < mPathItems.size(); i++) {
+            totalLength += pathLength(i);
         }
         float start = totalLength * mCache.mSegment.start;
         float end = totalLength * mCache.mSegment.end;
 
         if (start < end) {
             float curLen = 0.0;
-            for (auto &i : mPathItems) {
+            for (size_t i = 0; i < mPathItems.size(); i++) {
                 if (curLen > end) {
                     // update with empty path.
-                    i->updatePath(VPath());
+                    mPathItems[i]->updatePath(VPath());
                     continue;
                 }
-                float len = i->localPath().length();
+                float len = pathLength(i);
 
                 if (curLen < start && curLen + len < start) {
                     curLen += len;
                     // update with empty path.
-                    i->updatePath(VPath());
+                    mPathItems[i]->updatePath(VPath());
                     continue;
                 } else if (start <= curLen && end >= curLen + len) {
                     // inside segment
@@ -1385,8 +2410,8 @@ void LOTTrimItem::update()
                     local_start /= len;
                     float local_end = curLen + len < end ? len : end - curLen;
                     local_end /= len;
-                    mPathMesure.setRange(local_start, local_end);
-                    i->updatePath(mPathMesure.trim(i->localPath()));
+                    mPathItems[i]->updatePath(
+                        trimPath(i, local_start, local_end));
                     curLen += len;
                 }
             }
@@ -1394,11 +2419,40 @@ void LOTTrimItem::update()
     }
 }
 
+/*
+ * static shapes keep their length table and the last trim result in
+ * their VPathMesure across frames, so a matrix change or a repeated
+ * segment doesn't measure the path again.
+ */
+float LOTTrimItem::pathLength(size_t index)
+{
+    LOTPathDataItem *item = mPathItems[index];
+
+    if (!item->staticLocalPath()) return item->localPath().length();
+
+    mPathMesures[index].setPath(item->localPath());
+    return mPathMesures[index].length();
+}
+
+VPath LOTTrimItem::trimPath(size_t index, float start, float end)
+{
+    LOTPathDataItem *item = mPathItems[index];
+    VPathMesure     &mesure = mPathMesures[index];
+
+    mesure.setRange(start, end);
+
+    if (!item->staticLocalPath()) return mesure.trim(item->localPath());
+
+    mesure.setPath(item->localPath());
+    return mesure.trim();
+}
+
 void LOTTrimItem::addPathItems(rlottie_std::vector<LOTPathDataItem *> &list,
                                size_t                          startOffset)
 {
     rlottie_std::copy(list.begin() + startOffset, list.end(),
               back_inserter(mPathItems));
+    mPathMesures.resize(mPathItems.size());
 }
 
 LOTRepeaterItem::LOTRepeaterItem(LOTRepeaterData *data, VArenaAlloc* allocator) : mRepeaterData(data)
@@ -1450,9 +2504,3 @@ void LOTRepeaterItem::update(int frameNo, const VMatrix &parentMatrix,
         mContents[i]->update(frameNo, result, newAlpha, newFlag);
     }
 }
-
-void LOTRepeaterItem::renderList(rlottie_std::vector<VDrawable *> &list)
-{
-    if (mHidden) return;
-    return LOTContentGroupItem::renderList(list);
-}
@@ -58,6 +58,41 @@ public:
     }
 };
 
+/*
+ * Finds the area of a frame that differs from the last frame. Every input
+ * of the composition (drawable, mask, clip) is added with its bounding
+ * rect and a state that changes whenever the input draws differently.
+ * The rect of an input that appeared, vanished or changed is dirty.
+ */
+class LOTDirtyTracker
+{
+public:
+   void reset();
+   bool valid() const { return mFrame != 0; }
+   void begin(const VRect &clip) { mFrame++; mDirty = VRect(); mClip = clip; }
+   const VRect &clip() const { return mClip; }
+   bool add(const void *key, const VRect &bbox, const rlottie_std::string &state);
+   bool add(const void *key, const VRect &bbox, size_t serial);
+   void add(VDrawable *drawable);
+   // every input added until endGroup() is dirty when dirty is set.
+   void beginGroup(bool dirty) { if (dirty) mForce++; mGroups.push_back(dirty); }
+   void endGroup() { if (mGroups.back()) mForce--; mGroups.pop_back(); }
+   VRect end();
+private:
+   struct Input {
+       VRect               bbox;
+       rlottie_std::string state;
+       size_t              frame{0};
+   };
+   rlottie_std::unordered_map<const void *, Input> mInputs;
+   rlottie_std::vector<bool>                       mGroups;
+   rlottie_std::string                             mState;
+   VRect                                           mDirty;
+   VRect                                           mClip;
+   size_t                                          mFrame{0};
+   int                                             mForce{0};
+};
+
 class LOTCompItem
 {
 public:
@@ -66,17 +101,39 @@ public:
    VSize size() const { return mViewSize;}
    void buildRenderTree();
    const LOTLayerNode * renderTree()const;
-   bool render(const rlottie::Surface &surface);
+   bool render(const rlottie::Surface &surface, rlottie::FrameStats *stats = nullptr,
+               size_t bands = 1, bool partial = false);
+   VRect dirtyRegion() const { return mDirtyRegion; }
+   void setSmoothImages(bool smooth);
    void setValue(const rlottie_std::string &keypath, LOTVariant &value);
+   void bindProperty(size_t binding, const rlottie_std::string &keypath,
+                     rlottie::Property prop);
+   void setValue(size_t binding, LOTVariant &value);
 private:
+   VRect dirtyArea(const rlottie::Surface &surface, const VRect &region);
+   void renderBands(const rlottie::Surface &surface, const VRect &region,
+                    const VRect &area, size_t count, rlottie::FrameStats *stats);
+   void renderBand(const rlottie::Surface &surface, const VRect &region,
+                   const VRect &band, bool needClear);
+   struct Target {
+       const void *buffer{nullptr};
+       size_t      bytesPerLine{0};
+       VRect       region;
+   };
    VBitmap                                     mSurface;
+   LOTDirtyTracker                             mDirtyTracker;
+   Target                                      mLastTarget;  // of the last tracked frame
+   VRect                                       mDirtyRegion; // of the last frame
    VMatrix                                     mScaleMatrix;
    VSize                                       mViewSize;
    LOTCompositionData                         *mCompData{nullptr};
    LOTLayerItem                               *mRootLayer{nullptr};
    VArenaAlloc                                 mAllocator{2048};
+   rlottie_std::vector<LOTFilterList>          mBindings; // by bindProperty()
+   LOTKeyFrameCursors                          mKeyFrameCursors;
    int                                         mCurFrameNo;
    bool                                        mKeepAspectRatio{true};
+   bool                                        mSmoothImages{false};
 };
 
 class LOTLayerMaskItem;
@@ -91,8 +148,8 @@ public:
 public:
     VSize                    mSize;
     VPath                    mPath;
-    VRle                     mMaskedRle;
     VRasterizer              mRasterizer;
+    size_t                   mRleSerial{0}; // changes with every new rle
     bool                     mRasterRequest{false};
 };
 
@@ -139,6 +196,43 @@ private:
 
 using DrawableList = VSpan<VDrawable *>;
 
+class LOTContentItem;
+class LOTContentGroupItem;
+class LOTPathDataItem;
+class LOTPaintDataItem;
+class LOTTrimItem;
+
+enum class ContentType : uchar
+{
+    Unknown,
+    Group,
+    Repeater,
+    Path,
+    Paint,
+    Trim
+};
+
+/*
+ * A node of the flattened content tree of a shape layer. The nodes are
+ * kept in traversal order, next is the index of the first node after the
+ * subtree so a group that didn't change can be skipped with one jump.
+ */
+struct LOTContentNode
+{
+    LOTContentItem *item;
+    ContentType     type;
+    uint32_t        parent; // index of the parent group node
+    uint32_t        next;
+};
+
+// what a group node passes down to its children during update.
+struct LOTContentState
+{
+    const VMatrix *matrix{nullptr};
+    float          alpha{1.0f};
+    DirtyFlag      flag;
+};
+
 class LOTLayerItem
 {
 public:
@@ -155,6 +249,13 @@ public:
    void preprocess(const VRect& clip);
    virtual DrawableList renderList(){ return {};}
    virtual void render(VPainter *painter, const VRle &mask, const VRle &matteRle);
+   virtual void collectDirty(LOTDirtyTracker &tracker);
+   // bounding rect of what render() can draw, in frame coordinates.
+   virtual VRect contentRect();
+   // the coverage render() draws, false if it isn't only solid colors.
+   virtual bool coverageRle(const VRle &inheritMask, bool luma, VRle &result);
+   // coverageRle() of the frame, shared by the bands of the frame.
+   bool frameCoverage(const VRle &inheritMask, bool luma, VRle &result);
    bool hasMatte() { if (mLayerData->mMatteType == MatteType::None) return false; return true; }
    MatteType matteType() const { return mLayerData->mMatteType;}
    bool visible() const;
@@ -164,11 +265,14 @@ public:
    rlottie_std::vector<LOTMask>& cmasks() {return mCApiData->mMasks;}
    rlottie_std::vector<LOTNode *>& cnodes() {return mCApiData->mCNodeList;}
    const char* name() const {return mLayerData->name();}
-   virtual bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value);
-   VBitmap& bitmap() {return mRenderBuffer;}
+   virtual bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters);
+   virtual void setSmoothImages(bool) {}
 protected:
    virtual void preprocessStage(const VRect& clip) = 0;
    virtual void updateContent() = 0;
+   // the mask render() draws with, false if it hides the whole layer.
+   virtual bool buildMask(const VRle &inheritMask, VRle &mask);
+   bool frameMask(const VRle &inheritMask, VRle &mask);
    inline VMatrix combinedMatrix() const {return mCombinedMatrix;}
    inline int frameNo() const {return mFrameNo;}
    inline float combinedAlpha() const {return mCombinedAlpha;}
@@ -176,17 +280,31 @@ protected:
    float opacity(int frameNo) const {return mLayerData->opacity(frameNo);}
    inline DirtyFlag flag() const {return mDirtyFlag;}
    bool skipRendering() const {return (!visible() || vIsZero(combinedAlpha()));}
+   bool contentChanged() const
+   {
+       return mDynamicContent || mContentFrameNo == -1 ||
+              mLayerData->mAnimatedRanges.changed(mContentFrameNo, frameNo());
+   }
 protected:
    rlottie_std::unique_ptr<LOTLayerMaskItem>   mLayerMask;
    LOTLayerData                               *mLayerData{nullptr};
    LOTLayerItem                               *mParentLayer{nullptr};
    VMatrix                                     mCombinedMatrix;
-   VBitmap                                     mRenderBuffer;
    float                                       mCombinedAlpha{0.0};
    int                                         mFrameNo{-1};
+   int                                         mContentFrameNo{-1}; // frame of the last content update
    DirtyFlag                                   mDirtyFlag{DirtyFlagBit::All};
    bool                                        mComplexContent{false};
+   bool                                        mDynamicContent{false}; // has keypath overrides
    rlottie_std::unique_ptr<LOTCApiData>        mCApiData;
+   // the bands of a frame share its mask and coverage.
+   rlottie_std::mutex                          mFrameMutex;
+   VRle                                        mFrameMask;
+   VRle                                        mFrameCoverage;
+   bool                                        mFrameMaskDirty{true};
+   bool                                        mFrameMaskVisible{false};
+   bool                                        mFrameCoverageDirty{true};
+   bool                                        mFrameCoverageValid{false};
 };
 
 class LOTCompLayerItem: public LOTLayerItem
@@ -195,15 +313,24 @@ public:
    explicit LOTCompLayerItem(LOTLayerData *layerData, VArenaAlloc* allocator);
 
    void render(VPainter *painter, const VRle &mask, const VRle &matteRle) final;
+   void collectDirty(LOTDirtyTracker &tracker) final;
+   VRect contentRect() final;
+   bool coverageRle(const VRle &, bool, VRle &) final { return false; }
    void buildLayerNode() final;
-   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) override;
+   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters) override;
+   void setSmoothImages(bool smooth) final;
 protected:
    void preprocessStage(const VRect& clip) final;
    void updateContent() final;
+   bool buildMask(const VRle &inheritMask, VRle &mask) final;
 private:
+    void collectDirtyHelper(LOTDirtyTracker &tracker);
     void renderHelper(VPainter *painter, const VRle &mask, const VRle &matteRle);
     void renderMatteLayer(VPainter *painter, const VRle &inheritMask, const VRle &matteRle,
                           LOTLayerItem *layer, LOTLayerItem *src);
+    void renderCoverageMatte(VPainter *painter, const VRle &inheritMask,
+                             const VRle &coverage, const VRect &rect,
+                             LOTLayerItem *layer);
 private:
    rlottie_std::vector<LOTLayerItem*>            mLayers;
    rlottie_std::unique_ptr<LOTClipperItem>       mClipper;
@@ -231,12 +358,18 @@ public:
    explicit LOTShapeLayerItem(LOTLayerData *layerData, VArenaAlloc* allocator);
    DrawableList renderList() final;
    void buildLayerNode() final;
-   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) override;
+   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters) override;
 protected:
    void preprocessStage(const VRect& clip) final;
    void updateContent() final;
    rlottie_std::vector<VDrawable *>     mDrawableList;
    LOTContentGroupItem                 *mRoot{nullptr};
+   rlottie_std::vector<LOTContentNode>  mContentNodes; // update order
+   rlottie_std::vector<LOTContentState> mContentState; // per content node
+   rlottie_std::vector<LOTContentNode>  mRenderNodes;  // paints and repeaters in render order
+   rlottie_std::vector<LOTTrimItem *>   mTrimItems;    // in the order they apply
+   bool                                 mContentUpdated{true};
+   bool                                 mRenderListDirty{true}; // visibility of the content changed
 };
 
 class LOTNullLayerItem: public LOTLayerItem
@@ -254,6 +387,7 @@ public:
    explicit LOTImageLayerItem(LOTLayerData *layerData);
    void buildLayerNode() final;
    DrawableList renderList() final;
+   void setSmoothImages(bool smooth) final { mTexture.mSmooth = smooth; }
 protected:
    void preprocessStage(const VRect& clip) final;
    void updateContent() final;
@@ -289,36 +423,29 @@ public:
     explicit LOTLayerMaskItem(LOTLayerData *layerData);
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag);
     bool isStatic() const {return mStatic;}
-    VRle maskRle(const VRect &clipRect);
+    VRle maskRle();
     void preprocess(const VRect &clip);
+private:
+    bool useMaskBuffer(VRect &rect);
+    VRle opMaskRle();
+    VRle bufferMaskRle(const VRect &rect);
 public:
     rlottie_std::vector<LOTMaskItem>   mMasks;
     VRle                       mRle;
+    VRect                      mClip;  // clip of the frame
+    rlottie_std::mutex         mMutex; // the bands of a frame share the mask
+    size_t                     mRleSerial{0}; // changes with every new mRle
     bool                       mStatic{true};
     bool                       mDirty{true};
 };
 
-class LOTPathDataItem;
-class LOTPaintDataItem;
-class LOTTrimItem;
-
-enum class ContentType : uchar
-{
-    Unknown,
-    Group,
-    Path,
-    Paint,
-    Trim
-};
-
-class LOTContentGroupItem;
 class LOTContentItem
 {
 public:
    virtual ~LOTContentItem() = default;
    LOTContentItem& operator=(LOTContentItem&&) noexcept = delete;
-   virtual void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) = 0;   virtual void renderList(rlottie_std::vector<VDrawable *> &){}
-   virtual bool resolveKeyPath(LOTKeyPath &, uint, LOTVariant &) {return false;}
+   virtual void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) = 0;
+   virtual bool resolveKeyPath(LOTKeyPath &, uint, rlottie::Property, LOTFilterList &) {return false;}
    virtual ContentType type() const {return ContentType::Unknown;}
 };
 
@@ -329,23 +456,33 @@ public:
    explicit LOTContentGroupItem(LOTGroupData *data, VArenaAlloc* allocator);
    void addChildren(LOTGroupData *data, VArenaAlloc* allocator);
    void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) override;
-   void applyTrim();
+   bool updateTransform(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag, LOTContentState &state);
+   void flatten(uint32_t index, rlottie_std::vector<LOTContentNode> &nodes);
+   void flattenRender(rlottie_std::vector<LOTContentNode> &nodes);
+   void trimItems(rlottie_std::vector<LOTTrimItem *> &list);
    void processTrimItems(rlottie_std::vector<LOTPathDataItem *> &list);
    void processPaintItems(rlottie_std::vector<LOTPathDataItem *> &list);
-   void renderList(rlottie_std::vector<VDrawable *> &list) override;
-   ContentType type() const final {return ContentType::Group;}
+   ContentType type() const override {return ContentType::Group;}
    const VMatrix & matrix() const { return mMatrix;}
    const char* name() const
    {
        static const char* TAG = "__";
        return mModel.hasModel() ? mModel.name() : TAG;
    }
-   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) override;
+   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters) override;
 protected:
    rlottie_std::vector<LOTContentItem*>   mContents;
    VMatrix                                        mMatrix;
 private:
+   bool contentChanged(int frameNo) const
+   {
+       return !mModel.hasModel() || mDynamicContent || mPathOperator ||
+              mFrameNo == -1 || mModel.changed(mFrameNo, frameNo);
+   }
    LOTProxyModel<LOTGroupData> mModel;
+   int                         mFrameNo{-1};
+   bool                        mDynamicContent{false}; // has keypath overrides
+   bool                        mPathOperator{false}; // paths may be trimmed from outside
 };
 
 class LOTPathDataItem : public LOTContentItem
@@ -359,6 +496,8 @@ public:
    void finalPath(VPath& result);
    void updatePath(const VPath &path) {mTemp = path; mDirtyPath = true;}
    bool staticPath() const { return mStaticPath; }
+   // localPath() is the untouched path of a static shape.
+   bool staticLocalPath() const { return mStaticPath && mTemp.sharedWith(mLocalPath); }
    void setParent(LOTContentGroupItem *parent) {mParent = parent;}
    LOTContentGroupItem *parent() const {return mParent;}
 protected:
@@ -447,8 +586,9 @@ class LOTPaintDataItem : public LOTContentItem
 public:
    LOTPaintDataItem(bool staticContent);
    void addPathItems(rlottie_std::vector<LOTPathDataItem *> &list, size_t startOffset);
-   void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) override;
-   void renderList(rlottie_std::vector<VDrawable *> &list) final;
+   void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) final;
+   VDrawable *renderNode();
+   bool hasContent() const {return mContentToRender;}
    ContentType type() const final {return ContentType::Paint;}
 protected:
    virtual bool updateContent(int frameNo, const VMatrix &matrix, float alpha) = 0;
@@ -470,7 +610,7 @@ public:
    explicit LOTFillItem(LOTFillData *data);
 protected:
    bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
-   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) final;
+   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters) final;
 private:
    LOTProxyModel<LOTFillData> mModel;
 };
@@ -492,7 +632,7 @@ public:
    explicit LOTStrokeItem(LOTStrokeData *data);
 protected:
    bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
-   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) final;
+   bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, rlottie::Property prop, LOTFilterList &filters) final;
 private:
    LOTProxyModel<LOTStrokeData> mModel;
 };
@@ -527,6 +667,8 @@ private:
        }
        return false;
    }
+   float pathLength(size_t index);
+   VPath trimPath(size_t index, float start, float end);
    struct Cache {
         int                     mFrameNo{-1};
         LOTTrimData::Segment    mSegment{};
@@ -534,7 +676,7 @@ private:
    Cache                            mCache;
    rlottie_std::vector<LOTPathDataItem *>   mPathItems;
    LOTTrimData                     *mData{nullptr};
-   VPathMesure                      mPathMesure;
+   rlottie_std::vector<VPathMesure> mPathMesures;
    bool                             mDirty{true};
 };
 
@@ -543,7 +685,8 @@ class LOTRepeaterItem : public LOTContentGroupItem
 public:
    explicit LOTRepeaterItem(LOTRepeaterData *data, VArenaAlloc* allocator);
    void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) final;
-   void renderList(rlottie_std::vector<VDrawable *> &list) final;
+   ContentType type() const final {return ContentType::Repeater;}
+   bool hidden() const {return mHidden;}
 private:
    LOTRepeaterData             *mRepeaterData{nullptr};
    bool                         mHidden{false};
@@ -18,14 +18,36 @@
 
 #include "lottieloader.h"
 #include "lottieparser.h"
+#include "lottieserializer.h"
 
 #include <cstring>
 #include <stdio.h>
 
+#ifdef _WIN32
+#ifndef LOTTIE_NOSTDSTREAM_SUPPORT
+#include <fstream>
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifdef LOTTIE_CACHE_SUPPORT
 
+#include <list>
 #include <mutex>
 
+/*
+ * The cache is split into shards selected by the hash of the key, each
+ * with its own lock and lru list, so that concurrent loads of different
+ * resources don't serialize on a single mutex. Every hit or insert stamps
+ * the entry from a global clock, so each shard list is ordered by the stamp
+ * and the oldest entry of the cache is the oldest of the shard tails. The
+ * entry count and the memory budget are global and enforced by evicting it.
+ * Concurrent loads of a key that is not cached yet share a single parse.
+ */
 class LottieModelCache {
 public:
     static LottieModelCache &instance()
@@ -33,44 +55,172 @@ public:
         static LottieModelCache CACHE;
         return CACHE;
     }
-    rlottie_std::shared_ptr<LOTModel> find(const rlottie_std::string &key)
-    {
-        rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
 
-        if (!mcacheSize) return nullptr;
+    template <typename Parser>
+    rlottie_std::shared_ptr<LOTModel> load(const rlottie_std::string &key,
+                                           Parser &&parse)
+    {
+        if (!mcacheSize.load(rlottie_std::memory_order_relaxed)) return parse();
+
+        Shard &shard = mShards[rlottie_std::hash<rlottie_std::string>()(key) % SHARD_COUNT];
+        SharedModel                      inflight;
+        rlottie_std::promise<ModelPtr>   promise;
+        {
+            rlottie_std::lock_guard<rlottie_std::mutex> guard(shard.mutex);
+
+            auto search = shard.hash.find(key);
+            if (search != shard.hash.end()) {
+                // move the entry to the front of the lru list.
+                shard.lru.splice(shard.lru.begin(), shard.lru, search->second);
+                search->second->stamp = ++mClock;
+                shard.stats.hits++;
+                return search->second->model;
+            }
+
+            auto pending = shard.pending.find(key);
+            if (pending != shard.pending.end()) {
+                inflight = pending->second;
+                shard.stats.hits++;
+            } else {
+                shard.pending[key] = promise.get_future().share();
+                shard.stats.misses++;
+            }
+        }
+
+        // an other thread is already parsing this resource.
+        if (inflight.valid()) return inflight.get();
+
+        auto model = parse();
+        {
+            rlottie_std::lock_guard<rlottie_std::mutex> guard(shard.mutex);
+            shard.pending.erase(key);
+            if (model && mcacheSize) add(shard, key, model);
+        }
+        promise.set_value(model);
+
+        evict();
+        return model;
+    }
 
-        auto search = mHash.find(key);
+    void configureCacheSize(size_t cacheSize)
+    {
+        mcacheSize = cacheSize;
 
-        return (search != mHash.end()) ? search->second : nullptr;
+        if (!cacheSize) {
+            for (auto &shard : mShards) {
+                rlottie_std::lock_guard<rlottie_std::mutex> guard(shard.mutex);
+                while (!shard.lru.empty()) erase(shard, shard.lru.begin());
+            }
+        } else {
+            evict();
+        }
+    }
 
+    void configureCacheBudget(size_t bytes)
+    {
+        mBudget = bytes;
+        evict();
     }
-    void add(const rlottie_std::string &key, rlottie_std::shared_ptr<LOTModel> value)
+
+    rlottie::ModelCacheStats stats()
     {
-        rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+        rlottie::ModelCacheStats stats;
+        for (auto &shard : mShards) {
+            rlottie_std::lock_guard<rlottie_std::mutex> guard(shard.mutex);
+            stats.hits += shard.stats.hits;
+            stats.misses += shard.stats.misses;
+            stats.evictions += shard.stats.evictions;
+        }
+        stats.count = mCount;
+        stats.size = mSize;
+        return stats;
+    }
 
-        if (!mcacheSize) return;
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    using ModelPtr = rlottie_std::shared_ptr<LOTModel>;
+    using SharedModel = rlottie_std::shared_future<ModelPtr>;
+
+    struct Entry {
+        rlottie_std::string key;
+        ModelPtr            model;
+        size_t              size;
+        size_t              stamp;
+    };
+    using LruList = rlottie_std::list<Entry>;
+
+    struct Shard {
+        LruList                                                     lru;
+        rlottie_std::unordered_map<rlottie_std::string, LruList::iterator> hash;
+        rlottie_std::unordered_map<rlottie_std::string, SharedModel>  pending;
+        rlottie::ModelCacheStats                                    stats;
+        rlottie_std::mutex                                          mutex;
+    };
 
-        //@TODO just remove the 1st element
-        // not the best of LRU logic
-        if (mcacheSize == mHash.size()) mHash.erase(mHash.cbegin());
+    LottieModelCache() = default;
 
-        mHash[key] = rlottie_std::move(value);
+    bool overLimit() const
+    {
+        size_t budget = mBudget;
+        return mCount > mcacheSize || (budget && mSize > budget);
     }
 
-    void configureCacheSize(size_t cacheSize)
+    // must be called with the shard locked.
+    void add(Shard &shard, const rlottie_std::string &key, const ModelPtr &model)
     {
-        rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
-        mcacheSize = cacheSize;
+        auto search = shard.hash.find(key);
+        if (search != shard.hash.end()) erase(shard, search->second);
+
+        size_t size = model->memorySize();
+        shard.lru.push_front({key, model, size, ++mClock});
+        shard.hash[key] = shard.lru.begin();
+        mSize += size;
+        mCount++;
+    }
 
-        if (!mcacheSize) mHash.clear();
+    // must be called with the shard locked.
+    void erase(Shard &shard, LruList::iterator it)
+    {
+        mSize -= it->size;
+        mCount--;
+        shard.hash.erase(it->key);
+        shard.lru.erase(it);
     }
 
-private:
-    LottieModelCache() = default;
+    // drop the least recently used model of the whole cache until both the
+    // entry count and the memory budget are respected.
+    void evict()
+    {
+        while (overLimit()) {
+            Shard *oldest = nullptr;
+            size_t stamp = 0;
+            for (auto &shard : mShards) {
+                rlottie_std::lock_guard<rlottie_std::mutex> guard(shard.mutex);
+                if (shard.lru.empty()) continue;
+                if (!oldest || shard.lru.back().stamp < stamp) {
+                    oldest = &shard;
+                    stamp = shard.lru.back().stamp;
+                }
+            }
+            if (!oldest) break;
+
+            rlottie_std::lock_guard<rlottie_std::mutex> guard(oldest->mutex);
+            // the tail was touched or evicted meanwhile, look again.
+            if (oldest->lru.empty() || oldest->lru.back().stamp != stamp) continue;
+            if (!overLimit()) break;
+
+            erase(*oldest, rlottie_std::prev(oldest->lru.end()));
+            oldest->stats.evictions++;
+        }
+    }
 
-    rlottie_std::unordered_map<rlottie_std::string, rlottie_std::shared_ptr<LOTModel>>  mHash;
-    rlottie_std::mutex                                                  mMutex;
-    size_t                                                      mcacheSize{10};
+    rlottie_std::array<Shard, SHARD_COUNT>  mShards;
+    rlottie_std::atomic<size_t>             mcacheSize{10};
+    rlottie_std::atomic<size_t>             mBudget{0};
+    rlottie_std::atomic<size_t>             mCount{0};
+    rlottie_std::atomic<size_t>             mSize{0};
+    rlottie_std::atomic<size_t>             mClock{0};
 };
 
 #else
@@ -82,9 +232,14 @@ public:
         static LottieModelCache CACHE;
         return CACHE;
     }
-    rlottie_std::shared_ptr<LOTModel> find(const rlottie_std::string &) { return nullptr; }
-    void add(const rlottie_std::string &, rlottie_std::shared_ptr<LOTModel>) {}
+    template <typename Parser>
+    rlottie_std::shared_ptr<LOTModel> load(const rlottie_std::string &, Parser &&parse)
+    {
+        return parse();
+    }
     void configureCacheSize(size_t) {}
+    void configureCacheBudget(size_t) {}
+    rlottie::ModelCacheStats stats() { return {}; }
 };
 
 #endif
@@ -94,6 +249,16 @@ void LottieLoader::configureModelCacheSize(size_t cacheSize)
     LottieModelCache::instance().configureCacheSize(cacheSize);
 }
 
+void LottieLoader::configureModelCacheBudget(size_t bytes)
+{
+    LottieModelCache::instance().configureCacheBudget(bytes);
+}
+
+rlottie::ModelCacheStats LottieLoader::modelCacheStats()
+{
+    return LottieModelCache::instance().stats();
+}
+
 static rlottie_std::string dirname(const rlottie_std::string &path)
 {
     const char *ptr = strrchr(path.c_str(), '/');
@@ -104,75 +269,163 @@ static rlottie_std::string dirname(const rlottie_std::string &path)
     return rlottie_std::string(path, 0, len);
 }
 
-bool LottieLoader::load(const rlottie_std::string &path, bool cachePolicy)
-{
-    if (cachePolicy) {
-        mModel = LottieModelCache::instance().find(path);
-        if (mModel) return true;
-    }
+/*
+ * Null terminated, writable content of a file, as required by the in-situ
+ * json parser and read by the binary model loader. On posix systems the file is mapped copy-on-write so that
+ * loading costs no allocation or copy; the mapping is followed by an
+ * anonymous zero page which provides the terminator.
+ */
+class FileBuffer {
+public:
+    explicit FileBuffer(const rlottie_std::string &path);
+    ~FileBuffer();
+    FileBuffer(const FileBuffer &) = delete;
+    FileBuffer &operator=(const FileBuffer &) = delete;
+    char *data() const { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    char *                 mData{nullptr};
+    size_t                 mSize{0};
+#ifdef _WIN32
+    rlottie_std::string    mContent;
+#else
+    size_t                 mMapSize{0};
+#endif
+};
+
+#ifdef _WIN32
 
+FileBuffer::FileBuffer(const rlottie_std::string &path)
+{
 #ifdef LOTTIE_NOSTDSTREAM_SUPPORT
     FILE* f = fopen(path.c_str(), "rb");
 
     if (!f) {
-        return false;
+        vCritical << "failed to open file = " << path.c_str();
+        return;
     }
     fseek(f, 0, SEEK_END);
     size_t size = ftell(f);
 
-    rlottie_std::vector<char> where(size);
-
     rewind(f);
-    fread(where.data(), sizeof(char), size, f);
-    rlottie_std::string content(where.data(), where.size());
-#else    
+    mContent.resize(size);
+    if (size) size = fread(&mContent[0], sizeof(char), size, f);
+    mContent.resize(size);
+    fclose(f);
+#else
     rlottie_std::ifstream f;
-    f.open(path);
+    f.open(path, rlottie_std::ios::in | rlottie_std::ios::binary);
 
     if (!f.is_open()) {
         vCritical << "failed to open file = " << path.c_str();
-        return false;
+        return;
     }
 
-    rlottie_std::string content;
-
-    rlottie_std::getline(f, content, '\0') ;
+    // read the whole file, binary models contain zero bytes.
+    f.seekg(0, rlottie_std::ios::end);
+    size_t size = size_t(f.tellg());
+    f.seekg(0, rlottie_std::ios::beg);
+    mContent.resize(size);
+    if (size) f.read(&mContent[0], size);
+    mContent.resize(size_t(f.gcount()));
     f.close();
 #endif
 
-    if (content.empty()) return false;
+    if (!mContent.empty()) {
+        mData = &mContent[0];
+        mSize = mContent.size();
+    }
+}
 
-    const char *str = content.c_str();
-    LottieParser parser(const_cast<char *>(str),
-                        dirname(path).c_str());
-    mModel = parser.model();
+FileBuffer::~FileBuffer() = default;
 
-    if (!mModel) return false;
+#else
 
-    if (cachePolicy)
-        LottieModelCache::instance().add(path, mModel);
+FileBuffer::FileBuffer(const rlottie_std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        vCritical << "failed to open file = " << path.c_str();
+        return;
+    }
 
-    return true;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t size = size_t(st.st_size);
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        size_t mapSize = (size / page + 1) * page;
+
+        // reserve the file size plus at least one zero byte, then map
+        // the file over the start of the reservation.
+        void *base = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED) {
+            void *file = mmap(base, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_FIXED, fd, 0);
+            if (file != MAP_FAILED) {
+                mData = static_cast<char *>(base);
+                mSize = size;
+                mMapSize = mapSize;
+            } else {
+                munmap(base, mapSize);
+            }
+        }
+    }
+    close(fd);
+}
+
+FileBuffer::~FileBuffer()
+{
+    if (mData) munmap(mData, mMapSize);
+}
+
+#endif
+
+bool LottieLoader::load(const rlottie_std::string &path, bool cachePolicy)
+{
+    auto parse = [&path]() -> rlottie_std::shared_ptr<LOTModel> {
+        FileBuffer file(path);
+        if (!file.data()) return rlottie_std::shared_ptr<LOTModel>();
+
+        LottieParser parser(file.data(), dirname(path).c_str());
+        return parser.model();
+    };
+
+    mModel = cachePolicy ? LottieModelCache::instance().load(path, parse)
+                         : parse();
+
+    return mModel != nullptr;
 }
 
 bool LottieLoader::loadFromData(rlottie_std::string &&jsonData, const rlottie_std::string &key,
                                 const rlottie_std::string &resourcePath, bool cachePolicy)
 {
-    if (cachePolicy) {
-        mModel = LottieModelCache::instance().find(key);
-        if (mModel) return true;
-    }
+    auto parse = [&jsonData, &resourcePath]() {
+        LottieParser parser(const_cast<char *>(jsonData.c_str()),
+                            resourcePath.c_str());
+        return parser.model();
+    };
 
-    LottieParser parser(const_cast<char *>(jsonData.c_str()),
-                        resourcePath.c_str());
-    mModel = parser.model();
+    mModel = cachePolicy ? LottieModelCache::instance().load(key, parse)
+                         : parse();
+
+    return mModel != nullptr;
+}
+
+bool LottieLoader::loadFromBinary(const rlottie_std::string &path, bool cachePolicy)
+{
+    auto parse = [&path]() -> rlottie_std::shared_ptr<LOTModel> {
+        FileBuffer file(path);
+        if (!file.data()) return rlottie_std::shared_ptr<LOTModel>();
 
-    if (!mModel) return false;
+        return LottieSerializer::deserialize(file.data(), file.size());
+    };
 
-    if (cachePolicy)
-        LottieModelCache::instance().add(key, mModel);
+    mModel = cachePolicy ? LottieModelCache::instance().load(path, parse)
+                         : parse();
 
-    return true;
+    return mModel != nullptr;
 }
 
 rlottie_std::shared_ptr<LOTModel> LottieLoader::model()
@@ -26,9 +26,12 @@ class LottieLoader
 {
 public:
    static void configureModelCacheSize(size_t cacheSize);
+   static void configureModelCacheBudget(size_t bytes);
+   static rlottie::ModelCacheStats modelCacheStats();
    bool load(const rlottie_std::string &filePath, bool cachePolicy);
    bool loadFromData(rlottie_std::string &&jsonData, const rlottie_std::string &key,
                      const rlottie_std::string &resourcePath, bool cachePolicy);
+   bool loadFromBinary(const rlottie_std::string &filePath, bool cachePolicy);
    rlottie_std::shared_ptr<LOTModel> model();
 private:  
    rlottie_std::shared_ptr<LOTModel>    mModel;
@@ -18,6 +18,7 @@
 
 #include "lottiemodel.h"
 #include <cassert>
+#include <unordered_set>
 #include "vimageloader.h"
 #include "vline.h"
 
@@ -138,6 +139,203 @@ public:
 
 };
 
+/*
+ * Collects the animated frame ranges of every group bottom up. A shape
+ * group takes the ranges of its whole subtree, while a layer doesn't
+ * take the ranges of its child layers as they are updated on their own.
+ * Layers of a precomp asset are shared by all the layers that refer to
+ * it, so they are visited only once.
+ */
+class LottieAnimatedRangeVisitor {
+    rlottie_std::unordered_set<LOTLayerData *> mVisited;
+    uint32_t                                   mCursorCount{0};
+public:
+    size_t cursorCount() const { return mCursorCount; }
+    // every animated property also gets its keyframe cursor slot.
+    template <typename T>
+    void add(LOTFrameRanges &ranges, LOTAnimatable<T> &obj)
+    {
+        ranges.add(obj);
+        if (!obj.isStatic()) obj.animation().mCursorSlot = mCursorCount++;
+    }
+    void visitGroup(LOTGroupData *obj)
+    {
+        LOTFrameRanges &ranges = obj->mAnimatedRanges;
+        ranges.clear();
+        if (obj->mTransform) visitTransform(obj->mTransform, ranges);
+        for (const auto &child : obj->mChildren) {
+            if (child) visit(child, ranges);
+        }
+        ranges.merge();
+    }
+    void visitTransform(LOTTransformData *obj, LOTFrameRanges &ranges)
+    {
+        auto data = obj->data();
+        if (!data) return;
+        add(ranges, data->mRotation);
+        add(ranges, data->mScale);
+        add(ranges, data->mPosition);
+        add(ranges, data->mAnchor);
+        add(ranges, data->mOpacity);
+        if (data->mExtra) {
+            add(ranges, data->mExtra->m3DRx);
+            add(ranges, data->mExtra->m3DRy);
+            add(ranges, data->mExtra->m3DRz);
+            add(ranges, data->mExtra->mSeparateX);
+            add(ranges, data->mExtra->mSeparateY);
+        }
+    }
+    void visitGradient(LOTGradient *obj, LOTFrameRanges &ranges)
+    {
+        add(ranges, obj->mStartPoint);
+        add(ranges, obj->mEndPoint);
+        add(ranges, obj->mHighlightLength);
+        add(ranges, obj->mHighlightAngle);
+        add(ranges, obj->mOpacity);
+        add(ranges, obj->mGradient);
+    }
+    void visitDash(LOTDashProperty &obj, LOTFrameRanges &ranges)
+    {
+        for (auto &elm : obj.mData) add(ranges, elm);
+    }
+    void visit(LOTData *obj, LOTFrameRanges &ranges)
+    {
+        switch (obj->type()) {
+        case LOTData::Type::Layer: {
+            auto layer = static_cast<LOTLayerData *>(obj);
+            if (mVisited.insert(layer).second) visitGroup(layer);
+            break;
+        }
+        case LOTData::Type::ShapeGroup: {
+            auto group = static_cast<LOTGroupData *>(obj);
+            visitGroup(group);
+            ranges.add(group->mAnimatedRanges);
+            break;
+        }
+        case LOTData::Type::Repeater: {
+            auto repeater = static_cast<LOTRepeaterData *>(obj);
+            add(ranges, repeater->mCopies);
+            add(ranges, repeater->mOffset);
+            add(ranges, repeater->mTransform.mRotation);
+            add(ranges, repeater->mTransform.mScale);
+            add(ranges, repeater->mTransform.mPosition);
+            add(ranges, repeater->mTransform.mAnchor);
+            add(ranges, repeater->mTransform.mStartOpacity);
+            add(ranges, repeater->mTransform.mEndOpacity);
+            if (repeater->content()) {
+                visitGroup(repeater->content());
+                ranges.add(repeater->content()->mAnimatedRanges);
+            }
+            break;
+        }
+        case LOTData::Type::Transform: {
+            visitTransform(static_cast<LOTTransformData *>(obj), ranges);
+            break;
+        }
+        case LOTData::Type::Fill: {
+            auto fill = static_cast<LOTFillData *>(obj);
+            add(ranges, fill->mColor);
+            add(ranges, fill->mOpacity);
+            break;
+        }
+        case LOTData::Type::Stroke: {
+            auto stroke = static_cast<LOTStrokeData *>(obj);
+            add(ranges, stroke->mColor);
+            add(ranges, stroke->mOpacity);
+            add(ranges, stroke->mWidth);
+            visitDash(stroke->mDash, ranges);
+            break;
+        }
+        case LOTData::Type::GFill: {
+            visitGradient(static_cast<LOTGradient *>(obj), ranges);
+            break;
+        }
+        case LOTData::Type::GStroke: {
+            auto stroke = static_cast<LOTGStrokeData *>(obj);
+            visitGradient(stroke, ranges);
+            add(ranges, stroke->mWidth);
+            visitDash(stroke->mDash, ranges);
+            break;
+        }
+        case LOTData::Type::Rect: {
+            auto rect = static_cast<LOTRectData *>(obj);
+            add(ranges, rect->mPos);
+            add(ranges, rect->mSize);
+            add(ranges, rect->mRound);
+            break;
+        }
+        case LOTData::Type::Ellipse: {
+            auto ellipse = static_cast<LOTEllipseData *>(obj);
+            add(ranges, ellipse->mPos);
+            add(ranges, ellipse->mSize);
+            break;
+        }
+        case LOTData::Type::Shape: {
+            add(ranges, static_cast<LOTShapeData *>(obj)->mShape);
+            break;
+        }
+        case LOTData::Type::Polystar: {
+            auto star = static_cast<LOTPolystarData *>(obj);
+            add(ranges, star->mPos);
+            add(ranges, star->mPointCount);
+            add(ranges, star->mInnerRadius);
+            add(ranges, star->mOuterRadius);
+            add(ranges, star->mInnerRoundness);
+            add(ranges, star->mOuterRoundness);
+            add(ranges, star->mRotation);
+            break;
+        }
+        case LOTData::Type::Trim: {
+            auto trim = static_cast<LOTTrimData *>(obj);
+            add(ranges, trim->mStart);
+            add(ranges, trim->mEnd);
+            add(ranges, trim->mOffset);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+};
+
+void LOTFrameRanges::merge()
+{
+    if (mRanges.empty()) return;
+
+    rlottie_std::sort(mRanges.begin(), mRanges.end());
+    size_t last = 0;
+    for (size_t i = 1; i < mRanges.size(); i++) {
+        if (mRanges[i].first <= mRanges[last].second) {
+            mRanges[last].second =
+                rlottie_std::max(mRanges[last].second, mRanges[i].second);
+        } else {
+            mRanges[++last] = mRanges[i];
+        }
+    }
+    mRanges.resize(last + 1);
+    mRanges.shrink_to_fit();
+}
+
+/*
+ * A property keeps its first keyframe value up to the range start and
+ * its last keyframe value from the range end, so it can only change
+ * between two frames when the range starts before the later frame and
+ * ends after the earlier one.
+ */
+bool LOTFrameRanges::changed(int prevFrame, int curFrame) const
+{
+    float lo = rlottie_std::min(prevFrame, curFrame);
+    float hi = rlottie_std::max(prevFrame, curFrame);
+
+    // ranges are merged, so their end frames are sorted as well.
+    auto it = rlottie_std::upper_bound(
+        mRanges.cbegin(), mRanges.cend(), lo,
+        [](float frame, const rlottie_std::pair<float, float> &range) {
+            return frame < range.second;
+        });
+    return it != mRanges.cend() && it->first < hi;
+}
+
 void LOTCompositionData::processRepeaterObjects()
 {
     LottieRepeaterProcesser visitor;
@@ -150,6 +348,14 @@ void LOTCompositionData::updateStats()
     visitor.visit(mRootLayer);
 }
 
+void LOTCompositionData::updateAnimatedRanges()
+{
+    LottieAnimatedRangeVisitor visitor;
+    LOTFrameRanges             ranges;
+    visitor.visit(mRootLayer, ranges);
+    mKeyFrameCursorCount = visitor.cursorCount();
+}
+
 VMatrix LOTRepeaterTransform::matrix(int frameNo, float multiplier) const
 {
     VPointF scale = mScale.value(frameNo) / 100.f;
@@ -355,15 +561,109 @@ void LOTGradient::update(rlottie_std::unique_ptr<VGradient> &grad, int frameNo)
     }
 }
 
-void LOTAsset::loadImageData(rlottie_std::string data)
+static constexpr const unsigned char B64index[256] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  62, 63, 62, 62, 63, 52, 53, 54, 55, 56, 57,
+    58, 59, 60, 61, 0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,
+    7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    25, 0,  0,  0,  0,  63, 0,  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
+    37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51};
+
+static rlottie_std::string b64decode(const char *data, const size_t len)
+{
+    auto p = reinterpret_cast<const unsigned char *>(data);
+    int            pad = len > 0 && (len % 4 || p[len - 1] == '=');
+    const size_t   L = ((len + 3) / 4 - pad) * 4;
+    rlottie_std::string    str(L / 4 * 3 + pad, '\0');
+
+    for (size_t i = 0, j = 0; i < L; i += 4) {
+        int n = B64index[p[i]] << 18 | B64index[p[i + 1]] << 12 |
+                B64index[p[i + 2]] << 6 | B64index[p[i + 3]];
+        str[j++] = n >> 16;
+        str[j++] = n >> 8 & 0xFF;
+        str[j++] = n & 0xFF;
+    }
+    if (pad) {
+        int n = B64index[p[L]] << 18 | B64index[p[L + 1]] << 12;
+        str[str.size() - 1] = n >> 16;
+
+        if (len > L + 2 && p[L + 2] != '=') {
+            n |= B64index[p[L + 2]] << 6;
+            str.push_back(n >> 8 & 0xFF);
+        }
+    }
+    return str;
+}
+
+static rlottie_std::string convertFromBase64(const rlottie_std::string &str)
+{
+    // usual header look like "data:image/png;base64,"
+    // so need to skip till ','.
+    size_t startIndex = str.find(",", 0);
+    startIndex += 1;  // skip ","
+    size_t length = str.length() - startIndex;
+
+    const char *b64Data = str.c_str() + startIndex;
+
+    return b64decode(b64Data, length);
+}
+
+void LOTAsset::setImageData(rlottie_std::string data)
+{
+    mImageSource = rlottie_std::move(data);
+    mEmbeddedImage = true;
+}
+
+void LOTAsset::setImagePath(rlottie_std::string path)
+{
+    mImageSource = rlottie_std::move(path);
+    mEmbeddedImage = false;
+}
+
+void LOTAsset::setBitmap(VBitmap bitmap)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mImageMutex);
+    mBitmap = rlottie_std::move(bitmap);
+    mOpaque = mBitmap.opaque();
+    mImageSource.clear();
+    mImageDecoded = true;
+}
+
+// must be called with mImageMutex locked.
+void LOTAsset::decode() const
+{
+    if (mImageDecoded) return;
+
+    mImageDecoded = true;
+    if (mEmbeddedImage) {
+        auto data = convertFromBase64(mImageSource);
+        if (!data.empty())
+            mBitmap = VImageLoader::instance().load(data.c_str(), data.length());
+    } else if (!mImageSource.empty()) {
+        mBitmap = VImageLoader::instance().load(mImageSource.c_str());
+    }
+    mOpaque = mBitmap.opaque();
+    // the encoded image is not needed anymore.
+    rlottie_std::string().swap(mImageSource);
+}
+
+VBitmap LOTAsset::bitmap() const
 {
-    if (!data.empty())
-        mBitmap = VImageLoader::instance().load(data.c_str(), data.length());
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mImageMutex);
+    decode();
+    if (!mBitmap.valid()) return {};
+    // a view of the pixels, the ref count of the shared bitmap is not
+    // thread safe and must only be touched under the lock.
+    return VBitmap(mBitmap.data(), mBitmap.width(), mBitmap.height(),
+                   mBitmap.stride(), mBitmap.format());
 }
 
-void LOTAsset::loadImagePath(rlottie_std::string path)
+bool LOTAsset::opaque() const
 {
-    if (!path.empty()) mBitmap = VImageLoader::instance().load(path.c_str());
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mImageMutex);
+    decode();
+    return mOpaque;
 }
 
 rlottie_std::vector<LayerInfo> LOTCompositionData::layerInfoList() const
@@ -57,7 +57,7 @@ struct LOTModelStat
     uint16_t shapeLayerCount{0};
     uint16_t imageLayerCount{0};
     uint16_t nullLayerCount{0};
-
+    size_t   heapSize{0}; // keyframes, shapes and images owned by the model.
 };
 
 enum class MatteType: uchar
@@ -175,6 +175,7 @@ struct LOTKeyFrameValue
         return lerp(mStartValue, mEndValue, t);
     }
     float angle(float ) const { return 0;}
+    void prepare() {}
 };
 
 template <>
@@ -185,6 +186,58 @@ struct LOTKeyFrameValue<VPointF>
     VPointF mInTangent;
     VPointF mOutTangent;
     bool    mPathKeyFrame = false;
+    /*
+     * arc length of the path from its start to t = i / ArcSamples,
+     * filled once by prepare() so that value() and angle() can map
+     * progress to t without measuring the bezier every frame. Only path
+     * keyframes have it.
+     */
+    static constexpr int ArcSamples = 32;
+    rlottie_std::unique_ptr<float[]> mArcLength;
+
+    VBezier bezier() const {
+        return VBezier::fromPoints(mStartValue, mStartValue + mOutTangent,
+                                   mEndValue + mInTangent, mEndValue);
+    }
+
+    void prepare() {
+        if (!mPathKeyFrame) {
+            mArcLength.reset();
+            return;
+        }
+
+        VBezier b = bezier();
+        if (!mArcLength) mArcLength.reset(new float[ArcSamples + 1]);
+        mArcLength[0] = 0;
+        for (int i = 1; i <= ArcSamples; i++) {
+            float len = b.onInterval(float(i - 1) / ArcSamples,
+                                     float(i) / ArcSamples).length();
+            mArcLength[i] = mArcLength[i - 1] + len;
+        }
+    }
+
+    /*
+     * returns the bezier parameter at progress length (t * bezlen)
+     * by interpolating inside the arc length table, or by measuring
+     * the bezier when prepare() was not called.
+     */
+    float tAtProgress(float t) const {
+        const float *arcLength = mArcLength.get();
+        if (!arcLength) {
+            VBezier b = bezier();
+            return b.tAtLength(t * b.length());
+        }
+        float len = t * arcLength[ArcSamples];
+        if (len >= arcLength[ArcSamples] || vCompare(len, arcLength[ArcSamples]))
+            return 1.0f;
+        if (len <= 0) return 0.0f;
+
+        auto it = rlottie_std::upper_bound(arcLength, arcLength + ArcSamples + 1, len);
+        int  i = int(it - arcLength) - 1;
+        float segment = arcLength[i + 1] - arcLength[i];
+        float frac = segment > 0 ? (len - arcLength[i]) / segment : 0;
+        return (i + frac) / ArcSamples;
+    }
 
     VPointF value(float t) const {
         if (mPathKeyFrame) {
@@ -192,19 +245,14 @@ struct LOTKeyFrameValue<VPointF>
              * position along the path calcualated
              * using bezier at progress length (t * bezlen)
              */
-            VBezier b = VBezier::fromPoints(mStartValue, mStartValue + mOutTangent,
-                                       mEndValue + mInTangent, mEndValue);
-            return b.pointAt(b.tAtLength(t * b.length()));
-
+            return bezier().pointAt(tAtProgress(t));
         }
         return lerp(mStartValue, mEndValue, t);
     }
 
     float angle(float t) const {
         if (mPathKeyFrame) {
-            VBezier b = VBezier::fromPoints(mStartValue, mStartValue + mOutTangent,
-                                       mEndValue + mInTangent, mEndValue);
-            return b.angleAt(b.tAtLength(t * b.length()));
+            return bezier().angleAt(tAtProgress(t));
         }
         return 0;
     }
@@ -232,6 +280,53 @@ public:
     LOTKeyFrameValue<T>   mValue;
 };
 
+/*
+ * The keyframe found by the last lookup of every animated property. Each
+ * render tree keeps its own cursors, so the renderers sharing a model
+ * don't overwrite each other's hints. The properties get their slot when
+ * the model is built (see updateAnimatedRanges()) and a tree installs its
+ * cursors on the updating thread with a Scope.
+ */
+class LOTKeyFrameCursors
+{
+public:
+    static constexpr uint32_t NoSlot = uint32_t(-1);
+
+    explicit LOTKeyFrameCursors(size_t count = 0) : mCursors(count, 0) {}
+
+    // cursor of the slot in the cursors of this thread, if any.
+    static size_t *cursor(uint32_t slot)
+    {
+        if (slot == NoSlot) return nullptr;
+        LOTKeyFrameCursors *cursors = current();
+        if (!cursors || slot >= cursors->mCursors.size()) return nullptr;
+        return &cursors->mCursors[slot];
+    }
+
+    class Scope
+    {
+    public:
+        explicit Scope(LOTKeyFrameCursors *cursors) : mPrevious(current())
+        {
+            current() = cursors;
+        }
+        ~Scope() { current() = mPrevious; }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        LOTKeyFrameCursors *mPrevious;
+    };
+
+private:
+    static LOTKeyFrameCursors *&current()
+    {
+        static thread_local LOTKeyFrameCursors *cursors = nullptr;
+        return cursors;
+    }
+    rlottie_std::vector<size_t> mCursors;
+};
+
 template<typename T>
 class LOTAnimInfo
 {
@@ -242,11 +337,8 @@ public:
         if(mKeyFrames.back().mEndFrame <= frameNo)
             return mKeyFrames.back().mValue.mEndValue;
 
-        for(const auto &keyFrame : mKeyFrames) {
-            if (frameNo >= keyFrame.mStartFrame && frameNo < keyFrame.mEndFrame)
-                return keyFrame.value(frameNo);
-        }
-        return T();
+        const LOTKeyFrame<T> *keyFrame = find(frameNo);
+        return keyFrame ? keyFrame->value(frameNo) : T();
     }
 
     float angle(int frameNo) const {
@@ -254,11 +346,8 @@ public:
             (mKeyFrames.back().mEndFrame <= frameNo) )
             return 0;
 
-        for(const auto &keyFrame : mKeyFrames) {
-            if (frameNo >= keyFrame.mStartFrame && frameNo < keyFrame.mEndFrame)
-                return keyFrame.angle(frameNo);
-        }
-        return 0;
+        const LOTKeyFrame<T> *keyFrame = find(frameNo);
+        return keyFrame ? keyFrame->angle(frameNo) : 0;
     }
 
     bool changed(int prevFrame, int curFrame) const {
@@ -269,8 +358,51 @@ public:
                  (last < prevFrame  && last < curFrame));
     }
 
+    /*
+     * Returns the keyframe whose [start, end) range contains frameNo.
+     * The keyframe found by the last lookup of the updating render tree
+     * and the next one are tried first, so sequential playback resolves
+     * in O(1). Otherwise the keyframes, which are sorted by start frame,
+     * are binary searched. A linear scan remains as fallback for ranges
+     * with gaps.
+     */
+    const LOTKeyFrame<T> *find(int frameNo) const {
+        size_t  size = mKeyFrames.size();
+        size_t *cursor = LOTKeyFrameCursors::cursor(mCursorSlot);
+        size_t  hint = cursor ? *cursor : size;
+
+        if (hint < size && contains(mKeyFrames[hint], frameNo))
+            return &mKeyFrames[hint];
+
+        auto it = mKeyFrames.cend();
+        if (hint + 1 < size && contains(mKeyFrames[hint + 1], frameNo)) {
+            it = mKeyFrames.cbegin() + (hint + 1);
+        } else {
+            it = rlottie_std::upper_bound(mKeyFrames.cbegin(), mKeyFrames.cend(), frameNo,
+                                          [](int frame, const LOTKeyFrame<T> &keyFrame) {
+                                              return frame < keyFrame.mStartFrame;
+                                          });
+            if (it != mKeyFrames.cbegin() && contains(*(it - 1), frameNo)) {
+                --it;
+            } else {
+                it = rlottie_std::find_if(mKeyFrames.cbegin(), mKeyFrames.cend(),
+                                          [frameNo](const LOTKeyFrame<T> &keyFrame) {
+                                              return contains(keyFrame, frameNo);
+                                          });
+                if (it == mKeyFrames.cend()) return nullptr;
+            }
+        }
+        if (cursor) *cursor = size_t(it - mKeyFrames.cbegin());
+        return &*it;
+    }
+
 public:
     rlottie_std::vector<LOTKeyFrame<T>>    mKeyFrames;
+    uint32_t                               mCursorSlot{LOTKeyFrameCursors::NoSlot};
+private:
+    static bool contains(const LOTKeyFrame<T> &keyFrame, int frameNo) {
+        return frameNo >= keyFrame.mStartFrame && frameNo < keyFrame.mEndFrame;
+    }
 };
 
 template<typename T>
@@ -370,19 +502,47 @@ public:
             if(vec.back().mEndFrame <= frameNo)
                 return vec.back().mValue.mEndValue.toPath(path);
 
-            for(const auto &keyFrame : vec) {
-                if (frameNo >= keyFrame.mStartFrame && frameNo < keyFrame.mEndFrame) {
-                    LottieShapeData::lerp(keyFrame.mValue.mStartValue,
-                                          keyFrame.mValue.mEndValue,
-                                          keyFrame.progress(frameNo),
-                                          path);
-                }
+            const auto *keyFrame = animation().find(frameNo);
+            if (keyFrame) {
+                LottieShapeData::lerp(keyFrame->mValue.mStartValue,
+                                      keyFrame->mValue.mEndValue,
+                                      keyFrame->progress(frameNo),
+                                      path);
             }
         }
     }
 };
 
 
+/*
+ * Frame ranges in which some property of a subtree is animating, kept
+ * sorted and non overlapping. Outside of these ranges every property
+ * holds its first or last keyframe value, so the subtree looks the same
+ * for any two frames that no range separates.
+ */
+class LOTFrameRanges
+{
+public:
+    template<typename T>
+    void add(const LOTAnimatable<T> &obj) {
+        if (obj.isStatic() || obj.animation().mKeyFrames.empty()) return;
+        add(obj.animation().mKeyFrames.front().mStartFrame,
+            obj.animation().mKeyFrames.back().mEndFrame);
+    }
+    void add(float start, float end) {
+        mRanges.emplace_back(rlottie_std::min(start, end), rlottie_std::max(start, end));
+    }
+    void add(const LOTFrameRanges &other) {
+        mRanges.insert(mRanges.end(), other.mRanges.cbegin(), other.mRanges.cend());
+    }
+    void clear() { mRanges.clear(); }
+    void merge();
+    bool changed(int prevFrame, int curFrame) const;
+private:
+    rlottie_std::vector<rlottie_std::pair<float, float>> mRanges;
+};
+
+
 enum class LottieBlendMode: uchar
 {
     Normal = 0,
@@ -468,6 +628,7 @@ public:
 public:
     rlottie_std::vector<LOTData *>  mChildren;
     LOTTransformData       *mTransform{nullptr};
+    LOTFrameRanges          mAnimatedRanges; // of the transform and children
 };
 
 class LOTShapeGroupData : public LOTGroupData
@@ -486,9 +647,15 @@ struct LOTAsset
     };
     bool isStatic() const {return mStatic;}
     void setStatic(bool value) {mStatic = value;}
-    VBitmap  bitmap() const {return mBitmap;}
-    void loadImageData(rlottie_std::string data);
-    void loadImagePath(rlottie_std::string Path);
+    // decodes the image on the first call, the result is shared
+    // by all the users of the model. returns a view of the pixels
+    // which lives as long as the model.
+    VBitmap  bitmap() const;
+    // true if every pixel of bitmap() is opaque, found once at decode time.
+    bool     opaque() const;
+    void setImageData(rlottie_std::string data);
+    void setImagePath(rlottie_std::string path);
+    void setBitmap(VBitmap bitmap);
     Type                                      mAssetType{Type::Precomp};
     bool                                      mStatic{true};
     rlottie_std::string                               mRefId; // ref id
@@ -496,7 +663,14 @@ struct LOTAsset
     // image asset data
     int                                       mWidth{0};
     int                                       mHeight{0};
-    VBitmap                                   mBitmap;
+private:
+    void decode() const;
+    mutable rlottie_std::mutex                mImageMutex;
+    mutable rlottie_std::string               mImageSource; // base64 data uri or file path
+    mutable VBitmap                           mBitmap;
+    bool                                      mEmbeddedImage{false};
+    mutable bool                              mImageDecoded{false};
+    mutable bool                              mOpaque{false};
 };
 
 struct TransformDataExtra
@@ -549,6 +723,19 @@ public:
         if (isStatic()) return impl.mStaticData.mOpacity;
         return impl.mData->opacity(frameNo);
     }
+    void set(const VMatrix &matrix, float opacity)
+    {
+        setStatic(true);
+        new (&impl.mStaticData) static_data(VMatrix(matrix), opacity);
+    }
+    const TransformData* data() const
+    {
+        return isStatic() ? nullptr : impl.mData;
+    }
+    TransformData* data()
+    {
+        return isStatic() ? nullptr : impl.mData;
+    }
     LOTTransformData(const LOTTransformData&) = delete;
     LOTTransformData(LOTTransformData&&) = delete;
     LOTTransformData& operator=(LOTTransformData&) = delete;
@@ -603,7 +790,10 @@ public:
     int inFrame() const noexcept{return mInFrame;}
     int outFrame() const noexcept{return mOutFrame;}
     int startFrame() const noexcept{return mStartFrame;}
-    LottieColor solidColor() const noexcept{return mExtra->mSolidColor;}
+    LottieColor solidColor() const noexcept
+    {
+        return mExtra ? mExtra->mSolidColor : LottieColor();
+    }
     bool autoOrient() const noexcept{return mAutoOrient;}
     int timeRemap(int frameNo) const;
     VSize layerSize() const {return mLayerSize;}
@@ -670,8 +860,13 @@ public:
     long startFrame() const {return mStartFrame;}
     long endFrame() const {return mEndFrame;}
     VSize size() const {return mSize;}
+    size_t memorySize() const
+    {
+        return sizeof(*this) + mArenaAlloc.heapSize() + mStats.heapSize;
+    }
     void processRepeaterObjects();
     void updateStats();
+    void updateAnimatedRanges();
 public:
     rlottie_std::string          mVersion;
     VSize                mSize;
@@ -686,6 +881,7 @@ public:
     rlottie_std::vector<Marker>     mMarkers;
     VArenaAlloc             mArenaAlloc{2048};
     LOTModelStat            mStats;
+    size_t                  mKeyFrameCursorCount{0}; // slots of the animated properties
 };
 
 /**
@@ -1088,6 +1284,7 @@ public:
    size_t frameAtPos(double pos) const {return mRoot->frameAtPos(pos);}
    rlottie_std::vector<LayerInfo> layerInfoList() const { return mRoot->layerInfoList();}
    const rlottie_std::vector<Marker> &markers() const { return mRoot->markers();}
+   size_t memorySize() const {return sizeof(*this) + mRoot->memorySize();}
 public:
     rlottie_std::shared_ptr<LOTCompositionData> mRoot;
 };
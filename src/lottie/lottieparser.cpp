@@ -658,54 +658,6 @@ void LottieParserImpl::parseAssets(LOTCompositionData *composition)
     // update the precomp layers with the actual layer object
 }
 
-static constexpr const unsigned char B64index[256] = {
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  62, 63, 62, 62, 63, 52, 53, 54, 55, 56, 57,
-    58, 59, 60, 61, 0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,
-    7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
-    25, 0,  0,  0,  0,  63, 0,  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
-    37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51};
-
-rlottie_std::string b64decode(const char *data, const size_t len)
-{
-    auto p = reinterpret_cast<const unsigned char *>(data);
-    int            pad = len > 0 && (len % 4 || p[len - 1] == '=');
-    const size_t   L = ((len + 3) / 4 - pad) * 4;
-    rlottie_std::string    str(L / 4 * 3 + pad, '\0');
-
-    for (size_t i = 0, j = 0; i < L; i += 4) {
-        int n = B64index[p[i]] << 18 | B64index[p[i + 1]] << 12 |
-                B64index[p[i + 2]] << 6 | B64index[p[i + 3]];
-        str[j++] = n >> 16;
-        str[j++] = n >> 8 & 0xFF;
-        str[j++] = n & 0xFF;
-    }
-    if (pad) {
-        int n = B64index[p[L]] << 18 | B64index[p[L + 1]] << 12;
-        str[str.size() - 1] = n >> 16;
-
-        if (len > L + 2 && p[L + 2] != '=') {
-            n |= B64index[p[L + 2]] << 6;
-            str.push_back(n >> 8 & 0xFF);
-        }
-    }
-    return str;
-}
-
-static rlottie_std::string convertFromBase64(const rlottie_std::string &str)
-{
-    // usual header look like "data:image/png;base64,"
-    // so need to skip till ','.
-    size_t startIndex = str.find(",", 0);
-    startIndex += 1;  // skip ","
-    size_t length = str.length() - startIndex;
-
-    const char *b64Data = str.c_str() + startIndex;
-
-    return b64decode(b64Data, length);
-}
-
 /*
  *  rlottie_std::to_string() function is missing in VS2017
  *  so this is workaround for windows build
@@ -784,13 +736,16 @@ LOTAsset* LottieParserImpl::parseAsset()
     }
 
     if (asset->mAssetType == LOTAsset::Type::Image) {
+        // the image is decoded when it is rendered the first time.
+        compRef->mStats.heapSize += filename.capacity() +
+                                    size_t(asset->mWidth) * size_t(asset->mHeight) * 4;
         if (embededResource) {
             // embeder resource should start with "data:"
             if (filename.compare(0, 5, "data:") == 0) {
-                asset->loadImageData(convertFromBase64(filename));
+                asset->setImageData(rlottie_std::move(filename));
             }
         } else {
-            asset->loadImagePath(mDirPath + relativePath + filename);
+            asset->setImagePath(mDirPath + relativePath + filename);
         }
     }
 
@@ -1792,6 +1747,7 @@ void LottieParserImpl::getValue(LottieGradient &grad)
     while (NextArrayValue()) {
         grad.mGradient.push_back(GetDouble());
     }
+    compRef->mStats.heapSize += grad.mGradient.capacity() * sizeof(float);
 }
 
 void LottieParserImpl::getValue(int &val)
@@ -1875,6 +1831,7 @@ void LottieParserImpl::getValue(LottieShapeData &obj)
             points.push_back(mVertices[0]);  // end point
         }
     }
+    compRef->mStats.heapSize += points.capacity() * sizeof(VPointF);
     obj.mPoints = rlottie_std::move(points);
     obj.mClosed = closed;
 }
@@ -2014,6 +1971,8 @@ void LottieParserImpl::parseKeyFrame(LOTAnimInfo<T> &obj)
         }
     }
 
+    compRef->mStats.heapSize += sizeof(LOTKeyFrame<T>);
+
     if (parsed.hold) {
         keyframe.mValue.mEndValue = keyframe.mValue.mStartValue;
         keyframe.mEndFrame = keyframe.mStartFrame;
@@ -2099,6 +2058,11 @@ void LottieParserImpl::parsePropertyHelper(LOTAnimatable<T> &obj)
                 break;
             }
         }
+        /* keyframe end values are final only after the whole array */
+        if (!obj.isStatic()) {
+            for (auto &keyFrame : obj.animation().mKeyFrames)
+                keyFrame.mValue.prepare();
+        }
     }
 }
 
@@ -2319,6 +2283,7 @@ rlottie_std::shared_ptr<LOTModel> LottieParser::model()
     model->mRoot = d->composition();
     model->mRoot->processRepeaterObjects();
     model->mRoot->updateStats();
+    model->mRoot->updateAnimatedRanges();
 
 
 #ifdef LOTTIE_DUMP_TREE_SUPPORT
@@ -27,6 +27,8 @@
 // refactor it when we move to c++17
 // users should make sure proper combination
 // of id and value are passed while creating the object.
+// A value is held as a plain value, a function pointer with its user data
+// or a rlottie_std::function, only the last one may allocate.
 class LOTVariant
 {
 public:
@@ -34,6 +36,10 @@ public:
     using ColorFunc = rlottie_std::function<rlottie::Color(const rlottie::FrameInfo &)>;
     using PointFunc = rlottie_std::function<rlottie::Point(const rlottie::FrameInfo &)>;
     using SizeFunc = rlottie_std::function<rlottie::Size(const rlottie::FrameInfo &)>;
+    using ValueProc = float (*)(const rlottie::FrameInfo &, void *);
+    using ColorProc = rlottie::Color (*)(const rlottie::FrameInfo &, void *);
+    using PointProc = rlottie::Point (*)(const rlottie::FrameInfo &, void *);
+    using SizeProc = rlottie::Size (*)(const rlottie::FrameInfo &, void *);
 
     LOTVariant(rlottie::Property prop, const ValueFunc &v):mPropery(prop), mTag(Value)
     {
@@ -75,30 +81,97 @@ public:
         moveConstruct(impl.sizeFunc, rlottie_std::move(v));
     }
 
+    LOTVariant(rlottie::Property prop, float v)
+        :mPropery(prop), mTag(Value), mKind(Kind::Plain)
+    {
+        construct(impl.plain.value, v);
+    }
+
+    LOTVariant(rlottie::Property prop, const rlottie::Color &v)
+        :mPropery(prop), mTag(Color), mKind(Kind::Plain)
+    {
+        construct(impl.plain.color, v);
+    }
+
+    LOTVariant(rlottie::Property prop, const rlottie::Point &v)
+        :mPropery(prop), mTag(Point), mKind(Kind::Plain)
+    {
+        construct(impl.plain.point, v);
+    }
+
+    LOTVariant(rlottie::Property prop, const rlottie::Size &v)
+        :mPropery(prop), mTag(Size), mKind(Kind::Plain)
+    {
+        construct(impl.plain.size, v);
+    }
+
+    LOTVariant(rlottie::Property prop, ValueProc proc, void *data)
+        :mPropery(prop), mTag(Value), mKind(Kind::Proc)
+    {
+        impl.proc.func.value = proc;
+        impl.proc.data = data;
+    }
+
+    LOTVariant(rlottie::Property prop, ColorProc proc, void *data)
+        :mPropery(prop), mTag(Color), mKind(Kind::Proc)
+    {
+        impl.proc.func.color = proc;
+        impl.proc.data = data;
+    }
+
+    LOTVariant(rlottie::Property prop, PointProc proc, void *data)
+        :mPropery(prop), mTag(Point), mKind(Kind::Proc)
+    {
+        impl.proc.func.point = proc;
+        impl.proc.data = data;
+    }
+
+    LOTVariant(rlottie::Property prop, SizeProc proc, void *data)
+        :mPropery(prop), mTag(Size), mKind(Kind::Proc)
+    {
+        impl.proc.func.size = proc;
+        impl.proc.data = data;
+    }
+
+    explicit LOTVariant(rlottie::Property prop):mPropery(prop) {}
+
     rlottie::Property property() const { return mPropery; }
+    bool empty() const { return mTag == MonoState; }
 
-    const ColorFunc& color() const
+    rlottie::Color color(int frame) const
     {
         assert(mTag == Color);
-        return impl.colorFunc;
+        if (mKind == Kind::Plain) return impl.plain.color;
+        if (mKind == Kind::Proc)
+            return impl.proc.func.color(rlottie::FrameInfo(frame), impl.proc.data);
+        return impl.colorFunc(rlottie::FrameInfo(frame));
     }
 
-    const ValueFunc& value() const
+    float value(int frame) const
     {
         assert(mTag == Value);
-        return impl.valueFunc;
+        if (mKind == Kind::Plain) return impl.plain.value;
+        if (mKind == Kind::Proc)
+            return impl.proc.func.value(rlottie::FrameInfo(frame), impl.proc.data);
+        return impl.valueFunc(rlottie::FrameInfo(frame));
     }
 
-    const PointFunc& point() const
+    rlottie::Point point(int frame) const
     {
         assert(mTag == Point);
-        return impl.pointFunc;
+        if (mKind == Kind::Plain) return impl.plain.point;
+        if (mKind == Kind::Proc)
+            return impl.proc.func.point(rlottie::FrameInfo(frame), impl.proc.data);
+        return impl.pointFunc(rlottie::FrameInfo(frame));
     }
 
-    const SizeFunc& size() const
+    rlottie::Size size(int frame) const
     {
         assert(mTag == Size);
-        return impl.sizeFunc;
+        if (mKind == Kind::Plain) return impl.plain.size;
+        if (mKind == Kind::Proc)
+            return impl.proc.func.size(rlottie::FrameInfo(frame), impl.proc.data);
+        return impl.sizeFunc(rlottie::FrameInfo(frame));
     }
 
     LOTVariant() = default;
@@ -122,51 +195,72 @@ private:
 
     void Move(LOTVariant&& other)
     {
-        switch (other.mTag) {
-        case Type::Value:
-            moveConstruct(impl.valueFunc, rlottie_std::move(other.impl.valueFunc));
-            break;
-        case Type::Color:
-            moveConstruct(impl.colorFunc, rlottie_std::move(other.impl.colorFunc));
-            break;
-        case Type::Point:
-            moveConstruct(impl.pointFunc, rlottie_std::move(other.impl.pointFunc));
-            break;
-        case Type::Size:
-            moveConstruct(impl.sizeFunc, rlottie_std::move(other.impl.sizeFunc));
-            break;
-        default:
-            break;
+        if (other.mKind == Kind::Func) {
+            switch (other.mTag) {
+            case Type::Value:
+                moveConstruct(impl.valueFunc, rlottie_std::move(other.impl.valueFunc));
+                break;
+            case Type::Color:
+                moveConstruct(impl.colorFunc, rlottie_std::move(other.impl.colorFunc));
+                break;
+            case Type::Point:
+                moveConstruct(impl.pointFunc, rlottie_std::move(other.impl.pointFunc));
+                break;
+            case Type::Size:
+                moveConstruct(impl.sizeFunc, rlottie_std::move(other.impl.sizeFunc));
+                break;
+            default:
+                break;
+            }
+        } else {
+            copyFixed(other);
         }
         mTag = other.mTag;
+        mKind = other.mKind;
         mPropery = other.mPropery;
         other.mTag = MonoState;
     }
 
     void Copy(const LOTVariant& other)
     {
-        switch (other.mTag) {
-        case Type::Value:
-            construct(impl.valueFunc, other.impl.valueFunc);
-            break;
-        case Type::Color:
-            construct(impl.colorFunc, other.impl.colorFunc);
-            break;
-        case Type::Point:
-            construct(impl.pointFunc, other.impl.pointFunc);
-            break;
-        case Type::Size:
-            construct(impl.sizeFunc, other.impl.sizeFunc);
-            break;
-        default:
-            break;
+        if (other.mKind == Kind::Func) {
+            switch (other.mTag) {
+            case Type::Value:
+                construct(impl.valueFunc, other.impl.valueFunc);
+                break;
+            case Type::Color:
+                construct(impl.colorFunc, other.impl.colorFunc);
+                break;
+            case Type::Point:
+                construct(impl.pointFunc, other.impl.pointFunc);
+                break;
+            case Type::Size:
+                construct(impl.sizeFunc, other.impl.sizeFunc);
+                break;
+            default:
+                break;
+            }
+        } else {
+            copyFixed(other);
         }
         mTag = other.mTag;
+        mKind = other.mKind;
         mPropery = other.mPropery;
     }
 
+    // plain values and function pointers are trivially copyable.
+    void copyFixed(const LOTVariant& other)
+    {
+        if (other.mKind == Kind::Plain)
+            construct(impl.plain, other.impl.plain);
+        else
+            construct(impl.proc, other.impl.proc);
+    }
+
     void Destroy()
     {
+        if (mKind != Kind::Func) return;
+
         switch(mTag) {
         case MonoState: {
             break;
@@ -191,91 +285,104 @@ private:
     }
 
     enum Type {MonoState, Value, Color, Point , Size};
+    enum class Kind : uchar {Func, Plain, Proc};
+    union PlainValue {
+      rlottie::Color   color;
+      float            value;
+      rlottie::Point   point;
+      rlottie::Size    size;
+      PlainValue(){}
+    };
+    struct ProcValue {
+      union {
+        ValueProc   value;
+        ColorProc   color;
+        PointProc   point;
+        SizeProc    size;
+      } func;
+      void         *data;
+    };
     rlottie::Property mPropery;
     Type              mTag{MonoState};
+    Kind              mKind{Kind::Func};
     union details{
       ColorFunc   colorFunc;
       ValueFunc   valueFunc;
       PointFunc   pointFunc;
       SizeFunc    sizeFunc;
+      PlainValue  plain;
+      ProcValue   proc;
       details(){}
       ~details(){}
     }impl;
 };
 
+/*
+ * Overrides of an object by property. The mask answers hasFilter() with
+ * one bit test, so objects without overrides read their model as before.
+ * The slots are only allocated by the first override.
+ */
 class LOTFilter
 {
 public:
+    static constexpr uint PropertyCount = uint(rlottie::Property::TrOpacity) + 1;
+
     void addValue(LOTVariant &value)
     {
         uint index = static_cast<uint>(value.property());
-        if (mBitset.test(index)) {
-            rlottie_std::replace_if(mFilters.begin(),
-                            mFilters.end(),
-                            [&value](const LOTVariant &e) {return e.property() == value.property();},
-                            value);
-        } else {
-            mBitset.set(index);
-            mFilters.push_back(value);
-        }
+        if (!mSlots) mSlots = rlottie_std::make_unique<LOTVariant[]>(PropertyCount);
+        mSlots[index] = value;
+        mMask |= 1u << index;
     }
 
     void removeValue(LOTVariant &value)
     {
         uint index = static_cast<uint>(value.property());
-        if (mBitset.test(index)) {
-            mBitset.reset(index);
-            mFilters.erase(rlottie_std::remove_if(mFilters.begin(),
-                                          mFilters.end(),
-                                          [&value](const LOTVariant &e) {return e.property() == value.property();}),
-                           mFilters.end());
+        if (hasFilter(value.property())) {
+            mMask &= ~(1u << index);
+            mSlots[index] = LOTVariant();
         }
     }
     bool hasFilter(rlottie::Property prop) const
     {
-        return mBitset.test(static_cast<uint>(prop));
+        return mMask & (1u << static_cast<uint>(prop));
     }
     LottieColor color(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Color col = data(prop).color()(info);
+        rlottie::Color col = data(prop).color(frame);
         return LottieColor(col.r(), col.g(), col.b());
     }
     VPointF point(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Point pt = data(prop).point()(info);
+        rlottie::Point pt = data(prop).point(frame);
         return VPointF(pt.x(), pt.y());
     }
     VSize scale(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Size sz = data(prop).size()(info);
+        rlottie::Size sz = data(prop).size(frame);
         return VSize(sz.w(), sz.h());
     }
     float opacity(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        float val = data(prop).value()(info);
+        float val = data(prop).value(frame);
         return val/100;
     }
     float value(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        return data(prop).value()(info);
+        return data(prop).value(frame);
     }
 private:
     const LOTVariant& data(rlottie::Property prop) const
     {
-        auto result = rlottie_std::find_if(mFilters.begin(),
-                                   mFilters.end(),
-                                   [prop](const LOTVariant &e){return e.property() == prop;});
-        return *result;
+        return mSlots[static_cast<uint>(prop)];
     }
-    rlottie_std::bitset<32>            mBitset{0};
-    rlottie_std::vector<LOTVariant>    mFilters;
+    rlottie_std::unique_ptr<LOTVariant[]>  mSlots;
+    uint32_t                               mMask{0};
 };
 
+// the filters of the objects a keypath resolves to.
+using LOTFilterList = rlottie_std::vector<LOTFilter *>;
+
 template <typename T>
 class LOTProxyModel
 {
@@ -353,6 +460,10 @@ public:
     LOTFilter& filter() {return mFilter;}
     const char* name() const {return _modelData->name();}
     LOTTransformData* transform() const { return _modelData->mTransform; }
+    bool changed(int prevFrame, int curFrame) const
+    {
+        return _modelData->mAnimatedRanges.changed(prevFrame, curFrame);
+    }
     VMatrix matrix(int frame) const
     {
         VMatrix mS, mR, mT;
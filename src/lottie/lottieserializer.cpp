@@ -0,0 +1,1032 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "lottieserializer.h"
+#include "vdebug.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+constexpr char     BLOB_MAGIC[8] = {'R', 'L', 'O', 'T', 'B', 'I', 'N', '\0'};
+constexpr uint32_t BLOB_VERSION = 2;
+constexpr uint32_t BLOB_BYTE_ORDER = 0x01020304;
+constexpr uint32_t NO_REF = 0xFFFFFFFF;
+
+/*
+ * References to objects that can be shared (layers of a precomp asset,
+ * keyframe interpolators) are written as an index. The index equal to
+ * the number of objects seen so far introduces a new object, whose
+ * content follows immediately.
+ */
+class LottieModelWriter {
+public:
+    explicit LottieModelWriter(rlottie_std::string &out) : mOut(out) {}
+
+    void write(const LOTCompositionData *comp)
+    {
+        mOut.append(BLOB_MAGIC, sizeof(BLOB_MAGIC));
+        pod(BLOB_VERSION);
+        pod(BLOB_BYTE_ORDER);
+
+        writeDataHeader(comp);
+        string(comp->mVersion);
+        pod(comp->mSize);
+        pod(int64_t(comp->mStartFrame));
+        pod(int64_t(comp->mEndFrame));
+        pod(comp->mFrameRate);
+        pod(comp->mBlendMode);
+        pod(comp->mStats);
+
+        count(comp->mMarkers.size());
+        for (const auto &marker : comp->mMarkers) {
+            string(rlottie_std::get<0>(marker));
+            pod(int32_t(rlottie_std::get<1>(marker)));
+            pod(int32_t(rlottie_std::get<2>(marker)));
+        }
+
+        // asset contents first, so that layers can refer to them
+        // by index, then the layer list of the precomp assets.
+        count(comp->mAssets.size());
+        for (const auto &it : comp->mAssets) writeAsset(it.second);
+        for (const auto &it : comp->mAssets) {
+            count(it.second->mLayers.size());
+            for (const auto &layer : it.second->mLayers) writeData(layer);
+        }
+
+        writeData(comp->mRootLayer);
+    }
+
+private:
+    template <typename T>
+    void pod(const T &value)
+    {
+        static_assert(rlottie_std::is_trivially_copyable<T>::value,
+                      "only plain data can be copied to the blob");
+        mOut.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void count(size_t value) { pod(uint32_t(value)); }
+    void string(const rlottie_std::string &str)
+    {
+        count(str.size());
+        mOut.append(str);
+    }
+
+    void writeDataHeader(const LOTData *obj)
+    {
+        pod(obj->type());
+        pod(uint8_t(obj->isStatic()));
+        pod(uint8_t(obj->hidden()));
+        const char *name = obj->name();
+        string(name ? name : "");
+    }
+
+    void writeAsset(const LOTAsset *asset)
+    {
+        mAssets[asset] = uint32_t(mAssets.size());
+        pod(asset->mAssetType);
+        pod(uint8_t(asset->mStatic));
+        string(asset->mRefId);
+        pod(int32_t(asset->mWidth));
+        pod(int32_t(asset->mHeight));
+
+        VBitmap bitmap = asset->bitmap();
+        if (!bitmap.valid()) {
+            pod(uint8_t(0));
+            return;
+        }
+        pod(uint8_t(1));
+        size_t rowBytes = bitmap.width() * bitmap.depth() / 8;
+        pod(bitmap.format());
+        count(bitmap.width());
+        count(bitmap.height());
+        for (size_t row = 0; row < bitmap.height(); row++) {
+            mOut.append(reinterpret_cast<const char *>(bitmap.data() +
+                                                       row * bitmap.stride()),
+                        rowBytes);
+        }
+    }
+
+    void writeInterpolator(const VInterpolator *interpolator)
+    {
+        if (!interpolator) {
+            pod(NO_REF);
+            return;
+        }
+        auto search = mInterpolators.find(interpolator);
+        if (search != mInterpolators.end()) {
+            pod(search->second);
+            return;
+        }
+        uint32_t index = uint32_t(mInterpolators.size());
+        mInterpolators[interpolator] = index;
+        pod(index);
+        pod(*interpolator);
+    }
+
+    void writeValue(float value) { pod(value); }
+    void writeValue(const VPointF &value) { pod(value); }
+    void writeValue(const LottieColor &value) { pod(value); }
+    void writeValue(const LottieShapeData &value)
+    {
+        count(value.mPoints.size());
+        mOut.append(reinterpret_cast<const char *>(value.mPoints.data()),
+                    value.mPoints.size() * sizeof(VPointF));
+        pod(uint8_t(value.mClosed));
+    }
+    void writeValue(const LottieGradient &value)
+    {
+        count(value.mGradient.size());
+        mOut.append(reinterpret_cast<const char *>(value.mGradient.data()),
+                    value.mGradient.size() * sizeof(float));
+    }
+
+    template <typename T>
+    void writeValue(const LOTKeyFrameValue<T> &value)
+    {
+        writeValue(value.mStartValue);
+        writeValue(value.mEndValue);
+    }
+    // the arc length table is rebuilt on load, not stored.
+    void writeValue(const LOTKeyFrameValue<VPointF> &value)
+    {
+        pod(value.mStartValue);
+        pod(value.mEndValue);
+        pod(value.mInTangent);
+        pod(value.mOutTangent);
+        pod(uint8_t(value.mPathKeyFrame));
+    }
+
+    template <typename T>
+    void write(const LOTAnimatable<T> &obj)
+    {
+        pod(uint8_t(obj.isStatic()));
+        if (obj.isStatic()) {
+            writeValue(obj.value());
+            return;
+        }
+        const auto &keyFrames = obj.animation().mKeyFrames;
+        count(keyFrames.size());
+        for (const auto &keyFrame : keyFrames) {
+            pod(keyFrame.mStartFrame);
+            pod(keyFrame.mEndFrame);
+            writeInterpolator(keyFrame.mInterpolator);
+            writeValue(keyFrame.mValue);
+        }
+    }
+
+    void write(const LOTDashProperty &dash)
+    {
+        count(dash.mData.size());
+        for (const auto &elm : dash.mData) write(elm);
+    }
+
+    void writeData(const LOTData *obj)
+    {
+        if (!obj) {
+            pod(NO_REF);
+            return;
+        }
+        auto search = mObjects.find(obj);
+        if (search != mObjects.end()) {
+            pod(search->second);
+            return;
+        }
+        uint32_t index = uint32_t(mObjects.size());
+        mObjects[obj] = index;
+        pod(index);
+
+        writeDataHeader(obj);
+        switch (obj->type()) {
+        case LOTData::Type::Layer:
+            writeLayer(static_cast<const LOTLayerData *>(obj));
+            break;
+        case LOTData::Type::ShapeGroup:
+            writeGroup(static_cast<const LOTGroupData *>(obj));
+            break;
+        case LOTData::Type::Transform:
+            writeTransform(static_cast<const LOTTransformData *>(obj));
+            break;
+        case LOTData::Type::Fill:
+            writeFill(static_cast<const LOTFillData *>(obj));
+            break;
+        case LOTData::Type::Stroke:
+            writeStroke(static_cast<const LOTStrokeData *>(obj));
+            break;
+        case LOTData::Type::GFill:
+            writeGradient(static_cast<const LOTGradient *>(obj));
+            pod(static_cast<const LOTGFillData *>(obj)->mFillRule);
+            break;
+        case LOTData::Type::GStroke:
+            writeGStroke(static_cast<const LOTGStrokeData *>(obj));
+            break;
+        case LOTData::Type::Rect:
+            writeRect(static_cast<const LOTRectData *>(obj));
+            break;
+        case LOTData::Type::Ellipse:
+            writeEllipse(static_cast<const LOTEllipseData *>(obj));
+            break;
+        case LOTData::Type::Shape:
+            pod(int32_t(static_cast<const LOTPath *>(obj)->mDirection));
+            write(static_cast<const LOTShapeData *>(obj)->mShape);
+            break;
+        case LOTData::Type::Polystar:
+            writePolystar(static_cast<const LOTPolystarData *>(obj));
+            break;
+        case LOTData::Type::Trim:
+            writeTrim(static_cast<const LOTTrimData *>(obj));
+            break;
+        case LOTData::Type::Repeater:
+            writeRepeater(static_cast<const LOTRepeaterData *>(obj));
+            break;
+        case LOTData::Type::Composition:
+            break;
+        }
+    }
+
+    void writeGroup(const LOTGroupData *obj)
+    {
+        count(obj->mChildren.size());
+        for (const auto &child : obj->mChildren) writeData(child);
+        writeData(obj->mTransform);
+    }
+
+    void writeLayer(const LOTLayerData *obj)
+    {
+        writeGroup(obj);
+        pod(obj->mMatteType);
+        pod(obj->mLayerType);
+        pod(obj->mBlendMode);
+        pod(uint8_t(obj->mHasPathOperator));
+        pod(uint8_t(obj->mHasMask));
+        pod(uint8_t(obj->mHasRepeater));
+        pod(uint8_t(obj->mHasGradient));
+        pod(uint8_t(obj->mAutoOrient));
+        pod(obj->mLayerSize);
+        pod(int32_t(obj->mParentId));
+        pod(int32_t(obj->mId));
+        pod(obj->mTimeStreatch);
+        pod(int32_t(obj->mInFrame));
+        pod(int32_t(obj->mOutFrame));
+        pod(int32_t(obj->mStartFrame));
+
+        const ExtraLayerData *extra = obj->mExtra.get();
+        pod(uint8_t(extra != nullptr));
+        if (!extra) return;
+
+        pod(extra->mSolidColor);
+        string(extra->mPreCompRefId);
+        write(extra->mTimeRemap);
+        pod(uint8_t(extra->mCompRef != nullptr));
+        pod(extra->mAsset ? mAssets[extra->mAsset] : NO_REF);
+        count(extra->mMasks.size());
+        for (const auto &mask : extra->mMasks) {
+            write(mask->mShape);
+            write(mask->mOpacity);
+            pod(uint8_t(mask->mInv));
+            pod(uint8_t(mask->mIsStatic));
+            pod(mask->mMode);
+        }
+    }
+
+    void writeTransform(const LOTTransformData *obj)
+    {
+        const TransformData *data = obj->data();
+        if (!data) {
+            pod(obj->matrix(0));
+            pod(obj->opacity(0));
+            return;
+        }
+        write(data->mRotation);
+        write(data->mScale);
+        write(data->mPosition);
+        write(data->mAnchor);
+        write(data->mOpacity);
+        pod(uint8_t(data->mExtra != nullptr));
+        if (data->mExtra) {
+            write(data->mExtra->m3DRx);
+            write(data->mExtra->m3DRy);
+            write(data->mExtra->m3DRz);
+            write(data->mExtra->mSeparateX);
+            write(data->mExtra->mSeparateY);
+            pod(uint8_t(data->mExtra->mSeparate));
+            pod(uint8_t(data->mExtra->m3DData));
+        }
+    }
+
+    void writeFill(const LOTFillData *obj)
+    {
+        pod(obj->mFillRule);
+        pod(uint8_t(obj->mEnabled));
+        write(obj->mColor);
+        write(obj->mOpacity);
+    }
+
+    void writeStroke(const LOTStrokeData *obj)
+    {
+        write(obj->mColor);
+        write(obj->mOpacity);
+        write(obj->mWidth);
+        pod(obj->mCapStyle);
+        pod(obj->mJoinStyle);
+        pod(obj->mMiterLimit);
+        write(obj->mDash);
+        pod(uint8_t(obj->mEnabled));
+    }
+
+    void writeGradient(const LOTGradient *obj)
+    {
+        pod(int32_t(obj->mGradientType));
+        write(obj->mStartPoint);
+        write(obj->mEndPoint);
+        write(obj->mHighlightLength);
+        write(obj->mHighlightAngle);
+        write(obj->mOpacity);
+        write(obj->mGradient);
+        pod(int32_t(obj->mColorPoints));
+        pod(uint8_t(obj->mEnabled));
+    }
+
+    void writeGStroke(const LOTGStrokeData *obj)
+    {
+        writeGradient(obj);
+        write(obj->mWidth);
+        pod(obj->mCapStyle);
+        pod(obj->mJoinStyle);
+        pod(obj->mMiterLimit);
+        write(obj->mDash);
+    }
+
+    void writeRect(const LOTRectData *obj)
+    {
+        pod(int32_t(obj->mDirection));
+        write(obj->mPos);
+        write(obj->mSize);
+        write(obj->mRound);
+    }
+
+    void writeEllipse(const LOTEllipseData *obj)
+    {
+        pod(int32_t(obj->mDirection));
+        write(obj->mPos);
+        write(obj->mSize);
+    }
+
+    void writePolystar(const LOTPolystarData *obj)
+    {
+        pod(int32_t(obj->mDirection));
+        pod(obj->mPolyType);
+        write(obj->mPos);
+        write(obj->mPointCount);
+        write(obj->mInnerRadius);
+        write(obj->mOuterRadius);
+        write(obj->mInnerRoundness);
+        write(obj->mOuterRoundness);
+        write(obj->mRotation);
+    }
+
+    void writeTrim(const LOTTrimData *obj)
+    {
+        write(obj->mStart);
+        write(obj->mEnd);
+        write(obj->mOffset);
+        pod(obj->mTrimType);
+    }
+
+    void writeRepeater(const LOTRepeaterData *obj)
+    {
+        writeData(obj->mContent);
+        write(obj->mTransform.mRotation);
+        write(obj->mTransform.mScale);
+        write(obj->mTransform.mPosition);
+        write(obj->mTransform.mAnchor);
+        write(obj->mTransform.mStartOpacity);
+        write(obj->mTransform.mEndOpacity);
+        write(obj->mCopies);
+        write(obj->mOffset);
+        pod(obj->mMaxCopies);
+        pod(uint8_t(obj->mProcessed));
+    }
+
+    rlottie_std::string &mOut;
+    rlottie_std::unordered_map<const LOTData *, uint32_t>       mObjects;
+    rlottie_std::unordered_map<const VInterpolator *, uint32_t> mInterpolators;
+    rlottie_std::unordered_map<const LOTAsset *, uint32_t>      mAssets;
+};
+
+/*
+ * Rebuilds the model in the arena of a new composition. Every read is
+ * bounds checked; a truncated or inconsistent blob sets mError and the
+ * partially built composition is discarded.
+ */
+class LottieModelReader {
+public:
+    LottieModelReader(const char *data, size_t size)
+        : mPos(data), mEnd(data + size)
+    {
+    }
+
+    rlottie_std::shared_ptr<LOTCompositionData> read()
+    {
+        char     magic[sizeof(BLOB_MAGIC)];
+        uint32_t version{0}, byteOrder{0};
+        bytes(magic, sizeof(magic));
+        pod(version);
+        pod(byteOrder);
+        if (mError || memcmp(magic, BLOB_MAGIC, sizeof(magic)) ||
+            version != BLOB_VERSION || byteOrder != BLOB_BYTE_ORDER) {
+            vWarning << "Input data is not a supported binary model!";
+            return nullptr;
+        }
+
+        auto sharedComposition = rlottie_std::make_shared<LOTCompositionData>();
+        LOTCompositionData *comp = sharedComposition.get();
+        mComp = comp;
+
+        readDataHeader(comp);
+        string(comp->mVersion);
+        pod(comp->mSize);
+        comp->mStartFrame = long(pod<int64_t>());
+        comp->mEndFrame = long(pod<int64_t>());
+        pod(comp->mFrameRate);
+        readEnum(comp->mBlendMode, LottieBlendMode::Normal,
+                 LottieBlendMode::OverLay);
+        pod(comp->mStats);
+
+        size_t markers = count();
+        for (size_t i = 0; i < markers && !mError; i++) {
+            rlottie_std::string comment;
+            string(comment);
+            int start = pod<int32_t>();
+            int end = pod<int32_t>();
+            comp->mMarkers.emplace_back(rlottie_std::move(comment), start, end);
+        }
+
+        size_t assets = count();
+        for (size_t i = 0; i < assets && !mError; i++) readAsset();
+        for (auto &asset : mAssets) {
+            size_t layers = count();
+            for (size_t i = 0; i < layers && !mError; i++)
+                asset->mLayers.push_back(readData<LOTLayerData>(LOTData::Type::Layer));
+        }
+
+        comp->mRootLayer = readData<LOTLayerData>(LOTData::Type::Layer);
+
+        if (mError || !comp->mRootLayer) {
+            vWarning << "Binary model data is corrupted!";
+            return nullptr;
+        }
+        comp->updateAnimatedRanges();
+        return sharedComposition;
+    }
+
+private:
+    VArenaAlloc &allocator() { return mComp->mArenaAlloc; }
+
+    void bytes(void *dst, size_t size)
+    {
+        if (mError || size_t(mEnd - mPos) < size) {
+            mError = true;
+            memset(dst, 0, size);
+            return;
+        }
+        memcpy(dst, mPos, size);
+        mPos += size;
+    }
+    template <typename T>
+    void pod(T &value)
+    {
+        static_assert(rlottie_std::is_trivially_copyable<T>::value,
+                      "only plain data can be copied from the blob");
+        bytes(&value, sizeof(T));
+    }
+    template <typename T>
+    T pod()
+    {
+        T value;
+        pod(value);
+        return value;
+    }
+    bool flag() { return pod<uint8_t>() != 0; }
+    // the renderer indexes tables with the enums, out of range is an error.
+    template <typename T>
+    void readEnum(T &value, T first, T last)
+    {
+        using Underlying = typename rlottie_std::underlying_type<T>::type;
+        pod(value);
+        auto raw = int64_t(Underlying(value));
+        if (raw < int64_t(Underlying(first)) || raw > int64_t(Underlying(last)))
+            mError = true;
+    }
+    // element count, every element takes at least one byte.
+    size_t count()
+    {
+        size_t value = pod<uint32_t>();
+        if (value > size_t(mEnd - mPos)) {
+            mError = true;
+            return 0;
+        }
+        return value;
+    }
+    void string(rlottie_std::string &str)
+    {
+        size_t size = count();
+        if (mError) return;
+        str.assign(mPos, size);
+        mPos += size;
+    }
+
+    void readDataHeader(LOTData *obj)
+    {
+        pod<LOTData::Type>();
+        obj->setStatic(flag());
+        obj->setHidden(flag());
+        rlottie_std::string name;
+        string(name);
+        if (!name.empty()) obj->setName(name.c_str());
+    }
+
+    void readAsset()
+    {
+        auto asset = allocator().make<LOTAsset>();
+        mAssets.push_back(asset);
+        pod(asset->mAssetType);
+        asset->mStatic = flag();
+        string(asset->mRefId);
+        asset->mWidth = pod<int32_t>();
+        asset->mHeight = pod<int32_t>();
+        comp()->mAssets[asset->mRefId] = asset;
+
+        if (!flag()) return;
+
+        auto   format = pod<VBitmap::Format>();
+        size_t width = count();
+        size_t height = count();
+        if (mError || format == VBitmap::Format::Invalid || !width || !height)
+            return;
+
+        VBitmap bitmap(width, height, format);
+        size_t  rowBytes = width * bitmap.depth() / 8;
+        if (rowBytes > bitmap.stride() ||
+            rowBytes * height > size_t(mEnd - mPos)) {
+            mError = true;
+            return;
+        }
+        for (size_t row = 0; row < height; row++) {
+            bytes(bitmap.data() + row * bitmap.stride(), rowBytes);
+        }
+        asset->setBitmap(rlottie_std::move(bitmap));
+    }
+
+    VInterpolator *readInterpolator()
+    {
+        uint32_t index = pod<uint32_t>();
+        if (index == NO_REF) return nullptr;
+        if (index < mInterpolators.size()) return mInterpolators[index];
+        if (index != mInterpolators.size()) {
+            mError = true;
+            return nullptr;
+        }
+        auto obj = allocator().make<VInterpolator>();
+        pod(*obj);
+        mInterpolators.push_back(obj);
+        return obj;
+    }
+
+    void readValue(float &value) { pod(value); }
+    void readValue(VPointF &value) { pod(value); }
+    void readValue(LottieColor &value) { pod(value); }
+    void readValue(LottieShapeData &value)
+    {
+        size_t size = count();
+        if (size * sizeof(VPointF) > size_t(mEnd - mPos)) {
+            mError = true;
+            return;
+        }
+        value.mPoints.resize(size);
+        bytes(value.mPoints.data(), size * sizeof(VPointF));
+        value.mClosed = flag();
+    }
+    void readValue(LottieGradient &value)
+    {
+        size_t size = count();
+        if (size * sizeof(float) > size_t(mEnd - mPos)) {
+            mError = true;
+            return;
+        }
+        value.mGradient.resize(size);
+        bytes(value.mGradient.data(), size * sizeof(float));
+    }
+
+    template <typename T>
+    void readValue(LOTKeyFrameValue<T> &value)
+    {
+        readValue(value.mStartValue);
+        readValue(value.mEndValue);
+    }
+    void readValue(LOTKeyFrameValue<VPointF> &value)
+    {
+        pod(value.mStartValue);
+        pod(value.mEndValue);
+        pod(value.mInTangent);
+        pod(value.mOutTangent);
+        value.mPathKeyFrame = flag();
+        value.prepare();
+    }
+
+    template <typename T>
+    void read(LOTAnimatable<T> &obj)
+    {
+        if (flag()) {
+            readValue(obj.value());
+            return;
+        }
+        size_t size = count();
+        if (!size) {
+            mError = true;
+            return;
+        }
+        auto &keyFrames = obj.animation().mKeyFrames;
+        keyFrames.resize(size);
+        for (auto &keyFrame : keyFrames) {
+            pod(keyFrame.mStartFrame);
+            pod(keyFrame.mEndFrame);
+            keyFrame.mInterpolator = readInterpolator();
+            readValue(keyFrame.mValue);
+            if (mError) return;
+        }
+    }
+
+    void read(LOTDashProperty &dash)
+    {
+        size_t size = count();
+        for (size_t i = 0; i < size && !mError; i++) {
+            dash.mData.emplace_back();
+            read(dash.mData.back());
+        }
+    }
+
+    template <typename T>
+    T *readData(LOTData::Type type)
+    {
+        LOTData *obj = readData();
+        if (obj && obj->type() != type) {
+            mError = true;
+            return nullptr;
+        }
+        return static_cast<T *>(obj);
+    }
+
+    LOTData *readData()
+    {
+        uint32_t index = pod<uint32_t>();
+        if (mError || index == NO_REF) return nullptr;
+        if (index < mObjects.size()) {
+            // only a finished object can be shared, a reference to one
+            // still being read would make a cycle.
+            if (mComplete[index]) return mObjects[index];
+            mError = true;
+            return nullptr;
+        }
+        if (index != mObjects.size()) {
+            mError = true;
+            return nullptr;
+        }
+
+        // peek the type, the header is read by the object itself.
+        LOTData::Type type;
+        bytes(&type, sizeof(type));
+        mPos -= mError ? 0 : sizeof(type);
+
+        LOTData *obj = nullptr;
+        switch (type) {
+        case LOTData::Type::Layer:
+            obj = readLayer();
+            break;
+        case LOTData::Type::ShapeGroup:
+            obj = readGroup(allocator().make<LOTShapeGroupData>());
+            break;
+        case LOTData::Type::Transform:
+            obj = readTransform();
+            break;
+        case LOTData::Type::Fill:
+            obj = readFill();
+            break;
+        case LOTData::Type::Stroke:
+            obj = readStroke();
+            break;
+        case LOTData::Type::GFill: {
+            auto gfill = allocator().make<LOTGFillData>();
+            readGradient(gfill);
+            readEnum(gfill->mFillRule, FillRule::EvenOdd, FillRule::Winding);
+            obj = gfill;
+            break;
+        }
+        case LOTData::Type::GStroke:
+            obj = readGStroke();
+            break;
+        case LOTData::Type::Rect:
+            obj = readRect();
+            break;
+        case LOTData::Type::Ellipse:
+            obj = readEllipse();
+            break;
+        case LOTData::Type::Shape: {
+            auto shape = allocator().make<LOTShapeData>();
+            reserve(shape);
+            shape->mDirection = pod<int32_t>();
+            read(shape->mShape);
+            obj = shape;
+            break;
+        }
+        case LOTData::Type::Polystar:
+            obj = readPolystar();
+            break;
+        case LOTData::Type::Trim:
+            obj = readTrim();
+            break;
+        case LOTData::Type::Repeater:
+            obj = readRepeater();
+            break;
+        default:
+            mError = true;
+            break;
+        }
+        if (mError) return nullptr;
+        mComplete[index] = true;
+        return obj;
+    }
+
+    // registers the object before its content is read, so that the
+    // indices match the order in which the writer assigned them.
+    void reserve(LOTData *obj)
+    {
+        mObjects.push_back(obj);
+        mComplete.push_back(false);
+        readDataHeader(obj);
+    }
+
+    LOTData *readGroup(LOTGroupData *obj, bool registered = false)
+    {
+        if (!registered) reserve(obj);
+        size_t size = count();
+        for (size_t i = 0; i < size && !mError; i++) {
+            obj->mChildren.push_back(readData());
+            if (!obj->mChildren.back()) mError = true;
+        }
+        obj->mTransform = readData<LOTTransformData>(LOTData::Type::Transform);
+        return obj;
+    }
+
+    LOTData *readLayer()
+    {
+        auto obj = allocator().make<LOTLayerData>();
+        reserve(obj);
+        readGroup(obj, true);
+        readEnum(obj->mMatteType, MatteType::None, MatteType::LumaInv);
+        readEnum(obj->mLayerType, LayerType::Precomp, LayerType::Text);
+        readEnum(obj->mBlendMode, LottieBlendMode::Normal,
+                 LottieBlendMode::OverLay);
+        obj->mHasPathOperator = flag();
+        obj->mHasMask = flag();
+        obj->mHasRepeater = flag();
+        obj->mHasGradient = flag();
+        obj->mAutoOrient = flag();
+        pod(obj->mLayerSize);
+        obj->mParentId = pod<int32_t>();
+        obj->mId = pod<int32_t>();
+        pod(obj->mTimeStreatch);
+        obj->mInFrame = pod<int32_t>();
+        obj->mOutFrame = pod<int32_t>();
+        obj->mStartFrame = pod<int32_t>();
+
+        if (!flag()) return obj;
+
+        ExtraLayerData *extra = obj->extra();
+        pod(extra->mSolidColor);
+        string(extra->mPreCompRefId);
+        read(extra->mTimeRemap);
+        if (flag()) extra->mCompRef = comp();
+        uint32_t asset = pod<uint32_t>();
+        if (asset != NO_REF) {
+            if (asset < mAssets.size())
+                extra->mAsset = mAssets[asset];
+            else
+                mError = true;
+        }
+        size_t masks = count();
+        for (size_t i = 0; i < masks && !mError; i++) {
+            auto mask = allocator().make<LOTMaskData>();
+            read(mask->mShape);
+            read(mask->mOpacity);
+            mask->mInv = flag();
+            mask->mIsStatic = flag();
+            readEnum(mask->mMode, LOTMaskData::Mode::None,
+                     LOTMaskData::Mode::Difference);
+            extra->mMasks.push_back(mask);
+        }
+        return obj;
+    }
+
+    LOTData *readTransform()
+    {
+        auto obj = allocator().make<LOTTransformData>();
+        reserve(obj);
+        if (obj->isStatic()) {
+            VMatrix matrix = pod<VMatrix>();
+            float   opacity = pod<float>();
+            obj->set(matrix, opacity);
+            return obj;
+        }
+        auto data = allocator().make<TransformData>();
+        read(data->mRotation);
+        read(data->mScale);
+        read(data->mPosition);
+        read(data->mAnchor);
+        read(data->mOpacity);
+        if (flag()) {
+            data->createExtraData();
+            read(data->mExtra->m3DRx);
+            read(data->mExtra->m3DRy);
+            read(data->mExtra->m3DRz);
+            read(data->mExtra->mSeparateX);
+            read(data->mExtra->mSeparateY);
+            data->mExtra->mSeparate = flag();
+            data->mExtra->m3DData = flag();
+        }
+        obj->set(data, false);
+        return obj;
+    }
+
+    LOTData *readFill()
+    {
+        auto obj = allocator().make<LOTFillData>();
+        reserve(obj);
+        readEnum(obj->mFillRule, FillRule::EvenOdd, FillRule::Winding);
+        obj->mEnabled = flag();
+        read(obj->mColor);
+        read(obj->mOpacity);
+        return obj;
+    }
+
+    LOTData *readStroke()
+    {
+        auto obj = allocator().make<LOTStrokeData>();
+        reserve(obj);
+        read(obj->mColor);
+        read(obj->mOpacity);
+        read(obj->mWidth);
+        readEnum(obj->mCapStyle, CapStyle::Flat, CapStyle::Round);
+        readEnum(obj->mJoinStyle, JoinStyle::Miter, JoinStyle::Round);
+        pod(obj->mMiterLimit);
+        read(obj->mDash);
+        obj->mEnabled = flag();
+        return obj;
+    }
+
+    void readGradient(LOTGradient *obj)
+    {
+        reserve(obj);
+        obj->mGradientType = pod<int32_t>();
+        read(obj->mStartPoint);
+        read(obj->mEndPoint);
+        read(obj->mHighlightLength);
+        read(obj->mHighlightAngle);
+        read(obj->mOpacity);
+        read(obj->mGradient);
+        obj->mColorPoints = pod<int32_t>();
+        obj->mEnabled = flag();
+    }
+
+    LOTData *readGStroke()
+    {
+        auto obj = allocator().make<LOTGStrokeData>();
+        readGradient(obj);
+        read(obj->mWidth);
+        readEnum(obj->mCapStyle, CapStyle::Flat, CapStyle::Round);
+        readEnum(obj->mJoinStyle, JoinStyle::Miter, JoinStyle::Round);
+        pod(obj->mMiterLimit);
+        read(obj->mDash);
+        return obj;
+    }
+
+    LOTData *readRect()
+    {
+        auto obj = allocator().make<LOTRectData>();
+        reserve(obj);
+        obj->mDirection = pod<int32_t>();
+        read(obj->mPos);
+        read(obj->mSize);
+        read(obj->mRound);
+        return obj;
+    }
+
+    LOTData *readEllipse()
+    {
+        auto obj = allocator().make<LOTEllipseData>();
+        reserve(obj);
+        obj->mDirection = pod<int32_t>();
+        read(obj->mPos);
+        read(obj->mSize);
+        return obj;
+    }
+
+    LOTData *readPolystar()
+    {
+        auto obj = allocator().make<LOTPolystarData>();
+        reserve(obj);
+        obj->mDirection = pod<int32_t>();
+        readEnum(obj->mPolyType, LOTPolystarData::PolyType::Star,
+                 LOTPolystarData::PolyType::Polygon);
+        read(obj->mPos);
+        read(obj->mPointCount);
+        read(obj->mInnerRadius);
+        read(obj->mOuterRadius);
+        read(obj->mInnerRoundness);
+        read(obj->mOuterRoundness);
+        read(obj->mRotation);
+        return obj;
+    }
+
+    LOTData *readTrim()
+    {
+        auto obj = allocator().make<LOTTrimData>();
+        reserve(obj);
+        read(obj->mStart);
+        read(obj->mEnd);
+        read(obj->mOffset);
+        readEnum(obj->mTrimType, LOTTrimData::TrimType::Simultaneously,
+                 LOTTrimData::TrimType::Individually);
+        return obj;
+    }
+
+    LOTData *readRepeater()
+    {
+        auto obj = allocator().make<LOTRepeaterData>();
+        reserve(obj);
+        obj->setContent(readData<LOTShapeGroupData>(LOTData::Type::ShapeGroup));
+        if (!obj->mContent) mError = true;
+        read(obj->mTransform.mRotation);
+        read(obj->mTransform.mScale);
+        read(obj->mTransform.mPosition);
+        read(obj->mTransform.mAnchor);
+        read(obj->mTransform.mStartOpacity);
+        read(obj->mTransform.mEndOpacity);
+        read(obj->mCopies);
+        read(obj->mOffset);
+        pod(obj->mMaxCopies);
+        if (flag()) obj->markProcessed();
+        return obj;
+    }
+
+    LOTCompositionData *comp() { return mComp; }
+
+    const char *                         mPos;
+    const char *                         mEnd;
+    bool                                 mError{false};
+    LOTCompositionData *                 mComp{nullptr};
+    rlottie_std::vector<LOTData *>       mObjects;
+    rlottie_std::vector<bool>            mComplete;
+    rlottie_std::vector<VInterpolator *> mInterpolators;
+    rlottie_std::vector<LOTAsset *>      mAssets;
+};
+
+}  // namespace
+
+rlottie_std::string LottieSerializer::serialize(const LOTModel &model)
+{
+    rlottie_std::string blob;
+    if (!model.mRoot) return blob;
+
+    LottieModelWriter writer(blob);
+    writer.write(model.mRoot.get());
+    return blob;
+}
+
+rlottie_std::shared_ptr<LOTModel> LottieSerializer::deserialize(const char *data,
+                                                                size_t      size)
+{
+    LottieModelReader reader(data, size);
+    auto              composition = reader.read();
+    if (!composition) return nullptr;
+
+    auto model = rlottie_std::make_shared<LOTModel>();
+    model->mRoot = rlottie_std::move(composition);
+    return model;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOTTIESERIALIZER_H
+#define LOTTIESERIALIZER_H
+
+#include "lottiemodel.h"
+
+/*
+ * Converts a parsed LOTModel to and from a compact binary blob.
+ * The blob contains no pointers; shared objects and interpolators are
+ * stored once and referenced by index. Values are stored in the native
+ * byte order and the blob is rejected on a version or byte order mismatch.
+ */
+class LottieSerializer {
+public:
+    static rlottie_std::string serialize(const LOTModel &model);
+    static rlottie_std::shared_ptr<LOTModel> deserialize(const char *data,
+                                                         size_t      size);
+};
+
+#endif // LOTTIESERIALIZER_H
@@ -79,6 +79,8 @@ public:
     T* makeArray(size_t count) {
         return new T[count];
     }
+
+    size_t heapSize() const { return 0; }
 };
 #else //USE_DEFAULT_ALLOCATOR
 class VArenaAlloc {
@@ -153,6 +155,9 @@ public:
     // Destroy all allocated objects, free any heap allocations.
     void reset();
 
+    // Total size of the blocks allocated from the heap.
+    size_t heapSize() const { return fHeapSize; }
+
 private:
     static void AssertRelease(bool cond) { if (!cond) { ::abort(); } }
     static uint32_t ToU32(size_t v) {
@@ -238,6 +243,7 @@ private:
     // allocated is fFib0 * fFirstHeapAllocationSize. Using 2 ^ n * fFirstHeapAllocationSize
     // had too much slop for Android.
     uint32_t       fFib0 {1}, fFib1 {1};
+    size_t         fHeapSize {0};
 };
 
 // Helper for defining allocators with inline/reserved storage.
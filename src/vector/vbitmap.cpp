@@ -69,6 +69,22 @@ void VBitmap::Impl::fill(uint /*pixel*/)
     //@TODO
 }
 
+bool VBitmap::Impl::opaque()
+{
+    if (mFormat != VBitmap::Format::ARGB32_Premultiplied &&
+        mFormat != VBitmap::Format::ARGB32)
+        return false;
+
+    auto dataPtr = data();
+    for (uint col = 0; col < mHeight; col++) {
+        const uint *pixel = (const uint *)(dataPtr + mStride * col);
+        for (uint row = 0; row < mWidth; row++) {
+            if (vAlpha(pixel[row]) != 255) return false;
+        }
+    }
+    return true;
+}
+
 void VBitmap::Impl::updateLuma()
 {
     if (mFormat != VBitmap::Format::ARGB32_Premultiplied) return;
@@ -230,4 +246,110 @@ void VBitmap::updateLuma()
     if (mImpl) mImpl->updateLuma();
 }
 
+/*
+ * Returns true if every pixel of the bitmap is opaque.
+ * NOTE: this api scans the whole bitmap, cache the result.
+ */
+bool VBitmap::opaque() const
+{
+    return mImpl ? mImpl->opaque() : false;
+}
+
+VBitmapPool::Bitmap &VBitmapPool::Bitmap::operator=(Bitmap &&other) noexcept
+{
+    if (this == &other) return *this;
+    if (mPool) mPool->release(rlottie_std::move(mData), mBucket);
+    mBitmap = rlottie_std::move(other.mBitmap);
+    mData = rlottie_std::move(other.mData);
+    mPool = other.mPool;
+    mBucket = other.mBucket;
+    other.mBitmap = VBitmap();
+    other.mPool = nullptr;
+    return *this;
+}
+
+VBitmapPool::Bitmap::~Bitmap()
+{
+    if (mPool) mPool->release(rlottie_std::move(mData), mBucket);
+}
+
+VBitmapPool &VBitmapPool::instance()
+{
+    static VBitmapPool pool;
+    return pool;
+}
+
+VBitmapPool::Bitmap VBitmapPool::acquire(size_t w, size_t h,
+                                         VBitmap::Format format)
+{
+    Bitmap result;
+    if (!w || !h || format == VBitmap::Format::Invalid) return result;
+
+    size_t depth = (format == VBitmap::Format::Alpha8) ? 1 : 4;
+    size_t stride = (w * depth + 3) & ~size_t(3);
+    size_t size = stride * h;
+
+    size_t bucket = 0;
+    while (bucket < BucketCount && (size_t(MinBucketBytes) << bucket) < size)
+        bucket++;
+
+    if (bucket < BucketCount) {
+        {
+            rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+            auto &list = mFree[bucket];
+            if (!list.empty()) {
+                result.mData = rlottie_std::move(list.back());
+                list.pop_back();
+                mBytes -= size_t(MinBucketBytes) << bucket;
+            }
+        }
+        if (!result.mData)
+            result.mData.reset(new uchar[size_t(MinBucketBytes) << bucket]);
+        result.mPool = this;
+        result.mBucket = bucket;
+    } else {
+        // too big to be kept, freed with the bitmap.
+        result.mData.reset(new uchar[size]);
+    }
+    result.mBitmap.reset(result.mData.get(), w, h, stride, format);
+    return result;
+}
+
+void VBitmapPool::release(rlottie_std::unique_ptr<uchar[]> data, size_t bucket)
+{
+    if (!data) return;
+
+    size_t bytes = size_t(MinBucketBytes) << bucket;
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+    if (mBytes + bytes > mMaxBytes) return;
+    mFree[bucket].push_back(rlottie_std::move(data));
+    mBytes += bytes;
+}
+
+size_t VBitmapPool::maxBytes() const
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+    return mMaxBytes;
+}
+
+void VBitmapPool::setMaxBytes(size_t bytes)
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+    mMaxBytes = bytes;
+    // free the biggest buffers first.
+    for (size_t bucket = BucketCount; bucket-- && mBytes > mMaxBytes;) {
+        auto &list = mFree[bucket];
+        while (!list.empty() && mBytes > mMaxBytes) {
+            list.pop_back();
+            mBytes -= size_t(MinBucketBytes) << bucket;
+        }
+    }
+}
+
+size_t VBitmapPool::bytes() const
+{
+    rlottie_std::lock_guard<rlottie_std::mutex> guard(mMutex);
+    return mBytes;
+}
+
 V_END_NAMESPACE
@@ -52,6 +52,7 @@ public:
     void    setNeedClear(bool needClear) { if (mImpl) mImpl->mNeedClear = needClear; }
     void    fill(uint pixel);
     void    updateLuma();
+    bool    opaque() const;
 private:
     struct Impl {
         rlottie_std::unique_ptr<uchar[]> mOwnData{nullptr};
@@ -83,6 +84,7 @@ private:
         static uchar depth(VBitmap::Format format);
         void fill(uint);
         void updateLuma();
+        bool opaque();
     };
 #ifdef LOTTIE_DEFAULT_ALLOCATOR
     rlottie_std::shared_ptr<Impl> mImpl;
@@ -91,6 +93,48 @@ private:
 #endif
 };
 
+/*
+ * Recycles the pixel buffers of the short lived offscreen bitmaps of the
+ * render (mattes, precomps with opacity). A buffer is kept in the bucket
+ * of its power of two size and serves the next request of that bucket,
+ * from any layer, frame or render thread. At most maxBytes() of buffers
+ * are kept, a buffer released over the limit is freed.
+ */
+class VBitmapPool {
+public:
+    // a bitmap on a buffer of the pool, the buffer goes back to the pool
+    // when the Bitmap is destroyed. The pixels are not cleared.
+    class Bitmap {
+    public:
+        Bitmap() = default;
+        Bitmap(Bitmap &&other) noexcept { *this = rlottie_std::move(other); }
+        Bitmap &operator=(Bitmap &&other) noexcept;
+        ~Bitmap();
+        VBitmap &bitmap() { return mBitmap; }
+    private:
+        friend class VBitmapPool;
+        VBitmap                          mBitmap;
+        rlottie_std::unique_ptr<uchar[]> mData;
+        VBitmapPool                     *mPool{nullptr};
+        size_t                           mBucket{0};
+    };
+
+    static VBitmapPool &instance();
+    Bitmap acquire(size_t w, size_t h,
+                   VBitmap::Format format = VBitmap::Format::ARGB32_Premultiplied);
+    size_t maxBytes() const;
+    void   setMaxBytes(size_t bytes);
+    size_t bytes() const;  // kept by the pool, not counting the acquired ones
+private:
+    enum { MinBucketBytes = 4096, BucketCount = 20 };
+    void release(rlottie_std::unique_ptr<uchar[]> data, size_t bucket);
+
+    mutable rlottie_std::mutex                       mMutex;
+    rlottie_std::vector<rlottie_std::unique_ptr<uchar[]>> mFree[BucketCount];
+    size_t                                           mBytes{0};
+    size_t                                           mMaxBytes{32 * 1024 * 1024};
+};
+
 V_END_NAMESPACE
 
 #endif  // VBITMAP_H
@@ -62,6 +62,8 @@ struct VTexture {
     VBitmap  mBitmap;
     VMatrix  mMatrix;
     int      mAlpha{255};
+    bool     mOpaque{false};  // all the pixels of mBitmap are opaque
+    bool     mSmooth{false};  // bilinear filtering when transformed
 };
 
 class VBrush {
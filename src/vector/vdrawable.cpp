@@ -69,6 +69,7 @@ void VDrawable::preprocess(const VRect &clip)
         }
         mPath = {};
         mFlag &= ~DirtyFlag(DirtyState::Path);
+        mRleSerial++;
     }
 }
 
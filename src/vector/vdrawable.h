@@ -80,6 +80,7 @@ public:
     StrokeInfo              *mStrokeInfo{nullptr};
 
     DirtyFlag                mFlag{DirtyState::All};
+    size_t                   mRleSerial{0}; // changes with every new rle
     FillRule                 mFillRule{FillRule::Winding};
     VDrawable::Type          mType{Type::Fill};
 
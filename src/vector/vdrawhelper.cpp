@@ -53,12 +53,19 @@
 #include "vdrawhelper.h"
 #include <climits>
 #include <cstring>
+#include <algorithm>
 
 class VGradientCache {
 public:
     struct CacheInfo : public VColorTable {
-        inline CacheInfo(VGradientStops s) : stops(rlottie_std::move(s)) {}
+        inline CacheInfo(VGradientStops s, float a)
+            : stops(rlottie_std::move(s)), opacity(a) {}
+        bool match(const VGradient &gradient) const
+        {
+            return opacity == gradient.alpha() && stops == gradient.mStops;
+        }
         VGradientStops stops;
+        float          opacity;
     };
     using VCacheData = rlottie_std::shared_ptr<const CacheInfo>;
     using VCacheKey = int64_t;
@@ -84,7 +91,7 @@ public:
                 info = addCacheElement(hash_val, gradient);
             } else if (count == 1) {
                 auto search = mCache.find(hash_val);
-                if (search->second->stops == stops) {
+                if (search->second->match(gradient)) {
                     info = search->second;
                 } else {
                     // didn't find an exact match
@@ -94,7 +101,7 @@ public:
                 // we have a multiple data with same key
                 auto range = mCache.equal_range(hash_val);
                 for (auto it = range.first; it != range.second; ++it) {
-                    if (it->second->stops == stops) {
+                    if (it->second->match(gradient)) {
                         info = it->second;
                         break;
                     }
@@ -124,7 +131,8 @@ protected:
                 mCache.erase(mCache.begin());
             }
         }
-        auto cache_entry = rlottie_std::make_shared<CacheInfo>(gradient.mStops);
+        auto cache_entry =
+            rlottie_std::make_shared<CacheInfo>(gradient.mStops, gradient.alpha());
         cache_entry->alpha = generateGradientColorTable(
             gradient.mStops, gradient.alpha(), cache_entry->buffer32,
             VGradient::colorTableSize);
@@ -212,28 +220,204 @@ VBitmap::Format VRasterBuffer::prepare(VBitmap *image)
     return mFormat;
 }
 
+/*
+ * Alpha8 mask routines, the coverage math follows the blit functions
+ * of the VRle ops in vrle.cpp.
+ */
+static inline uchar maskDivBy255(int x)
+{
+    return uchar((x + (x >> 8) + 0x80) >> 8);
+}
+
+static void mask_span_Add(uchar *dest, int length, uint32_t coverage)
+{
+    const int ic = 255 - int(coverage);
+    for (int i = 0; i < length; i++)
+        dest[i] = uchar(coverage + maskDivBy255(ic * dest[i]));
+}
+
+static void mask_span_Subtract(uchar *dest, int length, uint32_t coverage)
+{
+    const int ic = 255 - int(coverage);
+    for (int i = 0; i < length; i++) dest[i] = maskDivBy255(ic * dest[i]);
+}
+
+static void mask_span_Intersect(uchar *dest, int length, uint32_t coverage)
+{
+    for (int i = 0; i < length; i++)
+        dest[i] = maskDivBy255(int(coverage) * dest[i]);
+}
+
+static void mask_span_Difference(uchar *dest, int length, uint32_t coverage)
+{
+    const int c = int(coverage);
+    for (int i = 0; i < length; i++)
+        dest[i] = maskDivBy255((255 - c) * dest[i] + c * (255 - dest[i]));
+}
+
+/*
+ * mask span functions by VMaskBuffer::Op, updated with the simd versions
+ * in vInitDrawhelperFunctions().
+ */
+static MaskSpanFunction maskSpanFunctions[] = {
+    mask_span_Add, mask_span_Subtract, mask_span_Intersect,
+    mask_span_Difference};
+
+void VMaskBuffer::reset(const VRect &rect, uchar value)
+{
+    if (rect.size() != mRect.size() || !mBitmap.bitmap().valid()) {
+        mBitmap = VBitmapPool::instance().acquire(
+            size_t(rect.width()), size_t(rect.height()), VBitmap::Format::Alpha8);
+        mData = mBitmap.bitmap().data();
+        mStride = mBitmap.bitmap().stride();
+    }
+    mRect = rect;
+    if (!rect.empty()) memset(scanLine(0), value, mStride * size_t(rect.height()));
+}
+
+/*
+ * clears the buffer from the cursor till (x, y), intersect keeps nothing
+ * outside of the rle.
+ */
+void VMaskBuffer::clearTill(int x, int y)
+{
+    const int width = mRect.width();
+    uchar *   buffer = scanLine(mCursor.y());
+    if (mCursor.y() < y) {
+        memset(buffer + mCursor.x(), 0, size_t(width - mCursor.x()));
+        buffer += mStride;
+        memset(buffer, 0, mStride * size_t(y - mCursor.y() - 1));
+        buffer += mStride * size_t(y - mCursor.y() - 1);
+        mCursor = VPoint(0, y);
+    }
+    if (mCursor.x() < x) memset(buffer + mCursor.x(), 0, size_t(x - mCursor.x()));
+    mCursor = VPoint(x, y);
+}
+
+void VMaskBuffer::composeSpans(size_t count, const VRle::Span *spans,
+                               void *userData)
+{
+    auto             self = static_cast<VMaskBuffer *>(userData);
+    const Op         op = self->mOp;
+    MaskSpanFunction func = maskSpanFunctions[uint(op)];
+
+    for (; count; --count, ++spans) {
+        const int x = spans->x - self->mRect.left();
+        const int y = spans->y - self->mRect.top();
+        const int len = spans->len;
+        uchar *   dest = self->scanLine(y) + x;
+
+        if (op == Op::Intersect) self->clearTill(x, y);
+        self->mCursor = VPoint(x + len, y);
+
+        // the solid and the empty coverage don't need the blend.
+        if (spans->coverage == 255) {
+            switch (op) {
+            case Op::Add:
+                memset(dest, 255, len);
+                continue;
+            case Op::Subtract:
+                memset(dest, 0, len);
+                continue;
+            case Op::Intersect:
+                continue;
+            default:
+                break;
+            }
+        } else if (spans->coverage == 0) {
+            if (op == Op::Intersect) memset(dest, 0, len);
+            continue;
+        }
+        func(dest, len, spans->coverage);
+    }
+}
+
+void VMaskBuffer::compose(const VRle &rle, Op op)
+{
+    if (mRect.empty()) return;
+
+    mOp = op;
+    mCursor = VPoint(0, 0);
+    rle.intersect(mRect, composeSpans, this);
+    if (op == Op::Intersect) {
+        clearTill(mRect.width(), mRect.height() - 1);
+    }
+}
+
+// end of the run of equal coverage starting at x, 8 bytes per compare.
+static inline int maskRunEnd(const uchar *line, int x, int width)
+{
+    const uchar    value = line[x];
+    const uint64_t pattern = value * uint64_t(0x0101010101010101);
+    uint64_t       word;
+
+    for (x++; x + 8 <= width; x += 8) {
+        memcpy(&word, line + x, sizeof(word));
+        if (word != pattern) break;
+    }
+    while (x < width && line[x] == value) x++;
+    return x;
+}
+
+bool VMaskBuffer::empty() const
+{
+    if (mRect.empty()) return true;
+
+    const int width = mRect.width();
+    for (int y = 0; y < mRect.height(); y++) {
+        const uchar *line = scanLine(y);
+        if (line[0] || maskRunEnd(line, 0, width) != width) return false;
+    }
+    return true;
+}
+
+VRle VMaskBuffer::toRle() const
+{
+    VRle                             rle;
+    rlottie_std::vector<VRle::Span> spans;
+    const int                        width = mRect.width();
+
+    for (int y = 0; y < mRect.height(); y++) {
+        const uchar *line = scanLine(y);
+        int          x = 0;
+        while (x < width) {
+            uchar value = line[x];
+            int   start = x;
+            x = maskRunEnd(line, x, width);
+            if (!value) continue;
+            VRle::Span span;
+            span.x = short(mRect.left() + start);
+            span.y = short(mRect.top() + y);
+            span.len = ushort(x - start);
+            span.coverage = value;
+            spans.push_back(span);
+        }
+    }
+    if (!spans.empty()) rle.addSpan(spans.data(), spans.size());
+    return rle;
+}
+
 void VSpanData::init(VRasterBuffer *image)
 {
     mRasterBuffer = image;
-    setDrawRegion(VRect(0, 0, int(image->width()), int(image->height())));
     mType = VSpanData::Type::None;
-    mBlendFunc = nullptr;
-    mUnclippedBlendFunc = nullptr;
+    setDrawRegion(VRect(0, 0, int(image->width()), int(image->height())));
 }
 
-extern CompositionFunction             COMP_functionForMode_C[];
-extern CompositionFunctionSolid        COMP_functionForModeSolid_C[];
-static const CompositionFunction *     functionForMode = COMP_functionForMode_C;
-static const CompositionFunctionSolid *functionForModeSolid =
-    COMP_functionForModeSolid_C;
+extern CompositionFunction      COMP_functionForMode_C[];
+extern CompositionFunctionSolid COMP_functionForModeSolid_C[];
+/*
+ * blend functions by BlendMode, the C versions of vcompositionfunctions.cpp
+ * replaced by the simd ones in vInitDrawhelperFunctions().
+ */
+static CompositionFunction      functionForMode[4];
+static CompositionFunctionSolid functionForModeSolid[4];
 
 /*
  *  Gradient Draw routines
  *
  */
 
-#define FIXPT_BITS 8
-#define FIXPT_SIZE (1 << FIXPT_BITS)
 static inline void getLinearGradientValues(LinearGradientValues *v,
                                            const VSpanData *     data)
 {
@@ -300,6 +484,31 @@ static inline uint32_t gradientPixel(const VGradientData *grad, float pos)
     return grad->mColorTable[gradientClamp(grad, ipos)];
 }
 
+/*
+ * colors at the fixed point positions t, t + inc, t + 2 * inc ...
+ */
+static void fetch_gradient_fixed(uint32_t *buffer, int length,
+                                 const VGradientData *gradient, int t, int inc)
+{
+    const uint32_t *end = buffer + length;
+    while (buffer < end) {
+        *buffer = gradientPixelFixed(gradient, t);
+        t += inc;
+        ++buffer;
+    }
+}
+
+static void fetch_radial(uint32_t *buffer, uint32_t *end, const Operator *op,
+                         const VSpanData *data, float det, float delta_det,
+                         float delta_delta_det, float b, float delta_b);
+
+/*
+ * span fetchers of the gradients, updated with the simd versions
+ * in vInitDrawhelperFunctions().
+ */
+static GradientFixedFetchProc  gradientFixedFetch = fetch_gradient_fixed;
+static GradientRadialFetchProc gradientRadialFetch = fetch_radial;
+
 void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
                            const VSpanData *data, int y, int x, int length)
 {
@@ -336,11 +545,7 @@ void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
                 // we can use fixed point math
                 int t_fixed = int(t * FIXPT_SIZE);
                 int inc_fixed = int(inc * FIXPT_SIZE);
-                while (buffer < end) {
-                    *buffer = gradientPixelFixed(gradient, t_fixed);
-                    t_fixed += inc_fixed;
-                    ++buffer;
-                }
+                gradientFixedFetch(buffer, length, gradient, t_fixed, inc_fixed);
             } else {
                 // we have to fall back to float math
                 while (buffer < end) {
@@ -376,9 +581,9 @@ static inline float radialDeterminant(float a, float b, float c)
     return (b * b) - (4 * a * c);
 }
 
-static void fetch(uint32_t *buffer, uint32_t *end, const Operator *op,
-                  const VSpanData *data, float det, float delta_det,
-                  float delta_delta_det, float b, float delta_b)
+static void fetch_radial(uint32_t *buffer, uint32_t *end, const Operator *op,
+                         const VSpanData *data, float det, float delta_det,
+                         float delta_delta_det, float b, float delta_b)
 {
     if (op->radial.extended) {
         while (buffer < end) {
@@ -461,8 +666,8 @@ void fetch_radial_gradient(uint32_t *buffer, const Operator *op,
         const float delta_delta_det =
             (delta_b_delta_b + 4 * op->radial.a * delta_rx_plus_ry) * inv_a;
 
-        fetch(buffer, end, op, data, det, delta_det, delta_delta_det, b,
-              delta_b);
+        gradientRadialFetch(buffer, end, op, data, det, delta_det,
+                            delta_delta_det, b, delta_b);
     } else {
         float rw = data->m23 * (y + float(0.5)) + data->m33 +
                    data->m13 * (x + float(0.5));
@@ -604,8 +809,98 @@ constexpr const T &clamp(const T &v, const T &lo, const T &hi)
 
 static const int buffer_size = 1024;
 static const int fixed_scale = 1 << 16;
-static void      blend_transformed_argb(size_t count, const VRle::Span *spans,
-                                        void *userData)
+
+/*
+ * Texture samples along a span, x and y are the 16.16 fixed point
+ * source position of the first pixel and fdx, fdy the increment per pixel.
+ */
+static void fetch_transformed(uint32_t *buffer, int length,
+                              const VBitmapData *bitmap, int x, int y, int fdx,
+                              int fdy)
+{
+    const int image_x1 = bitmap->x1;
+    const int image_y1 = bitmap->y1;
+    const int image_x2 = bitmap->x2 - 1;
+    const int image_y2 = bitmap->y2 - 1;
+
+    const uint32_t *end = buffer + length;
+    if (fdy == 0) {
+        // scale only, the whole span samples the same scanline.
+        const uint *line = reinterpret_cast<const uint *>(
+            bitmap->scanLine(clamp(y >> 16, image_y1, image_y2)));
+        while (buffer < end) {
+            *buffer++ = line[clamp(x >> 16, image_x1, image_x2)];
+            x += fdx;
+        }
+        return;
+    }
+
+    while (buffer < end) {
+        int px = clamp(x >> 16, image_x1, image_x2);
+        int py = clamp(y >> 16, image_y1, image_y2);
+        *buffer++ = reinterpret_cast<const uint *>(bitmap->scanLine(py))[px];
+        x += fdx;
+        y += fdy;
+    }
+}
+
+// same as fetch_transformed() but interpolates the 4 nearest pixels.
+static void fetch_transformed_bilinear(uint32_t *buffer, int length,
+                                       const VBitmapData *bitmap, int x, int y,
+                                       int fdx, int fdy)
+{
+    const int image_x1 = bitmap->x1;
+    const int image_y1 = bitmap->y1;
+    const int image_x2 = bitmap->x2 - 1;
+    const int image_y2 = bitmap->y2 - 1;
+
+    const uint32_t *end = buffer + length;
+    while (buffer < end) {
+        int x1 = x >> 16;
+        int y1 = y >> 16;
+        uint distx = uint(x & 0xffff) >> 8;
+        uint disty = uint(y & 0xffff) >> 8;
+        int x2 = clamp(x1 + 1, image_x1, image_x2);
+        int y2 = clamp(y1 + 1, image_y1, image_y2);
+        x1 = clamp(x1, image_x1, image_x2);
+        y1 = clamp(y1, image_y1, image_y2);
+
+        const uint *s1 = reinterpret_cast<const uint *>(bitmap->scanLine(y1));
+        const uint *s2 = reinterpret_cast<const uint *>(bitmap->scanLine(y2));
+        uint top = INTERPOLATE_PIXEL_256(s1[x1], 256 - distx, s1[x2], distx);
+        uint bottom = INTERPOLATE_PIXEL_256(s2[x1], 256 - distx, s2[x2], distx);
+        *buffer++ = INTERPOLATE_PIXEL_256(top, 256 - disty, bottom, disty);
+        x += fdx;
+        y += fdy;
+    }
+}
+
+/*
+ * texture fetchers, updated with the simd versions
+ * in vInitDrawhelperFunctions().
+ */
+static TextureFetchProc textureFetch = fetch_transformed;
+static TextureFetchProc textureFetchBilinear = fetch_transformed_bilinear;
+
+// span coverage combined with the alpha of the texture.
+static inline int textureCoverage(const VSpanData *data, const VRle::Span *span)
+{
+    const int alpha = data->mBitmap.const_alpha;
+    return alpha == 255 ? span->coverage : (span->coverage * alpha) >> 8;
+}
+
+/*
+ * A fully covered span of an opaque texture replaces the destination,
+ * it can be written without blending.
+ */
+static inline bool textureReplacesDest(const VSpanData *data, const Operator &op)
+{
+    return op.mode == BlendMode::Src ||
+           (op.mode == BlendMode::SrcOver && !data->mBitmap.hasAlpha);
+}
+
+static void blend_transformed_argb(size_t count, const VRle::Span *spans,
+                                   void *userData)
 {
     VSpanData *data = reinterpret_cast<VSpanData *>(userData);
     if (data->mBitmap.format != VBitmap::Format::ARGB32_Premultiplied &&
@@ -616,17 +911,21 @@ static void      blend_transformed_argb(size_t count, const VRle::Span *spans,
 
     Operator op = getOperator(data, spans, count);
     uint     buffer[buffer_size];
-
-    const int image_x1 = data->mBitmap.x1;
-    const int image_y1 = data->mBitmap.y1;
-    const int image_x2 = data->mBitmap.x2 - 1;
-    const int image_y2 = data->mBitmap.y2 - 1;
+    bool     replace = textureReplacesDest(data, op);
 
     if (data->fast_matrix) {
         // The increment pr x in the scanline
         int fdx = (int)(data->m11 * fixed_scale);
         int fdy = (int)(data->m12 * fixed_scale);
 
+        TextureFetchProc fetch = textureFetch;
+        int              offset = 0;
+        if (data->mBitmap.smooth) {
+            fetch = textureFetchBilinear;
+            // sample around the pixel centers.
+            offset = fixed_scale / 2;
+        }
+
         while (count--) {
             uint *target = data->buffer(spans->x, spans->y);
 
@@ -634,34 +933,34 @@ static void      blend_transformed_argb(size_t count, const VRle::Span *spans,
             const float cy = spans->y + float(0.5);
 
             int x =
-                int((data->m21 * cy + data->m11 * cx + data->dx) * fixed_scale);
+                int((data->m21 * cy + data->m11 * cx + data->dx) * fixed_scale) - offset;
             int y =
-                int((data->m22 * cy + data->m12 * cx + data->dy) * fixed_scale);
+                int((data->m22 * cy + data->m12 * cx + data->dy) * fixed_scale) - offset;
 
             int       length = spans->len;
-            const int coverage =
-                (spans->coverage * data->mBitmap.const_alpha) >> 8;
+            const int coverage = textureCoverage(data, spans);
+            if (coverage == 255 && replace) {
+                fetch(target, length, &data->mBitmap, x, y, fdx, fdy);
+                ++spans;
+                continue;
+            }
             while (length) {
-                int         l = rlottie_std::min(length, buffer_size);
-                const uint *end = buffer + l;
-                uint *      b = buffer;
-                while (b < end) {
-                    int px = clamp(x >> 16, image_x1, image_x2);
-                    int py = clamp(y >> 16, image_y1, image_y2);
-                    *b = reinterpret_cast<const uint *>(
-                        data->mBitmap.scanLine(py))[px];
-
-                    x += fdx;
-                    y += fdy;
-                    ++b;
-                }
+                int l = rlottie_std::min(length, buffer_size);
+                fetch(buffer, l, &data->mBitmap, x, y, fdx, fdy);
                 op.func(target, buffer, l, coverage);
+                x += fdx * l;
+                y += fdy * l;
                 target += l;
                 length -= l;
             }
             ++spans;
         }
     } else {
+        const int image_x1 = data->mBitmap.x1;
+        const int image_y1 = data->mBitmap.y1;
+        const int image_x2 = data->mBitmap.x2 - 1;
+        const int image_y2 = data->mBitmap.y2 - 1;
+
         const float fdx = data->m11;
         const float fdy = data->m12;
         const float fdw = data->m13;
@@ -676,8 +975,7 @@ static void      blend_transformed_argb(size_t count, const VRle::Span *spans,
             float w = data->m23 * cy + data->m13 * cx + data->m33;
 
             int       length = spans->len;
-            const int coverage =
-                (spans->coverage * data->mBitmap.const_alpha) >> 8;
+            const int coverage = textureCoverage(data, spans);
             while (length) {
                 int         l = rlottie_std::min(length, buffer_size);
                 const uint *end = buffer + l;
@@ -719,6 +1017,7 @@ static void blend_untransformed_argb(size_t count, const VRle::Span *spans,
     }
 
     Operator op = getOperator(data, spans, count);
+    bool     replace = textureReplacesDest(data, op);
 
     const int image_width = data->mBitmap.width;
     const int image_height = data->mBitmap.height;
@@ -739,11 +1038,13 @@ static void blend_untransformed_argb(size_t count, const VRle::Span *spans,
             }
             if (sx + length > image_width) length = image_width - sx;
             if (length > 0) {
-                const int coverage =
-                    (spans->coverage * data->mBitmap.const_alpha) >> 8;
+                const int   coverage = textureCoverage(data, spans);
                 const uint *src = (const uint *)data->mBitmap.scanLine(sy) + sx;
                 uint *      dest = data->buffer(x, spans->y);
-                op.func(dest, src, length, coverage);
+                if (coverage == 255 && replace)
+                    memcpy(dest, src, size_t(length) * sizeof(uint));
+                else
+                    op.func(dest, src, length, coverage);
             }
         }
         ++spans;
@@ -796,6 +1097,8 @@ void VSpanData::setup(const VBrush &brush, BlendMode /*mode*/,
         initTexture(
             &brush.mTexture->mBitmap, brush.mTexture->mAlpha, VBitmapData::Plain,
             brush.mTexture->mBitmap.rect());
+        mBitmap.hasAlpha = !brush.mTexture->mOpaque;
+        mBitmap.smooth = brush.mTexture->mSmooth;
         setupMatrix(brush.mTexture->mMatrix);
         break;
     }
@@ -843,10 +1146,48 @@ void VSpanData::initTexture(const VBitmap *bitmap, int alpha,
 
     mBitmap.const_alpha = alpha;
     mBitmap.type = type;
+    mBitmap.hasAlpha = true;
+    mBitmap.smooth = false;
 
     updateSpanFunc();
 }
 
+/*
+ * Blends the part of the spans inside the clip rect, used when the clip
+ * rect doesn't cover the whole subsurface (e.g a band of the frame).
+ */
+static void blend_clipped(size_t count, const VRle::Span *spans,
+                          void *userData)
+{
+    VSpanData *       data = reinterpret_cast<VSpanData *>(userData);
+    const VRect       clip = data->clipRect();
+    const VRle::Span *end = spans + count;
+
+    // the spans are sorted by y, skip the ones above the clip rect.
+    spans = rlottie_std::lower_bound(
+        spans, end, clip.top(),
+        [](const VRle::Span &span, int y) { return span.y < y; });
+
+    const int  nspans = 256;
+    VRle::Span clipped[nspans];
+    int        n = 0;
+    for (; spans < end && spans->y < clip.bottom(); ++spans) {
+        int x1 = rlottie_std::max(int(spans->x), clip.left());
+        int x2 = rlottie_std::min(spans->x + spans->len, clip.right());
+        if (x2 <= x1) continue;
+
+        clipped[n].x = short(x1);
+        clipped[n].y = spans->y;
+        clipped[n].len = ushort(x2 - x1);
+        clipped[n].coverage = spans->coverage;
+        if (++n == nspans) {
+            data->mUnclippedBlendFunc(size_t(n), clipped, data);
+            n = 0;
+        }
+    }
+    if (n) data->mUnclippedBlendFunc(size_t(n), clipped, data);
+}
+
 void VSpanData::updateSpanFunc()
 {
     switch (mType) {
@@ -871,6 +1212,12 @@ void VSpanData::updateSpanFunc()
         break;
     }
     }
+
+    if (mUnclippedBlendFunc &&
+        mClip != VRect(0, 0, mDrawableSize.width(), mDrawableSize.height()))
+        mBlendFunc = &blend_clipped;
+    else
+        mBlendFunc = mUnclippedBlendFunc;
 }
 
 #if !defined(__SSE2__) && !defined(__ARM_NEON__)
@@ -918,12 +1265,17 @@ void vInitDrawhelperFunctions()
 {
     vInitBlendFunctions();
 
+    rlottie_std::copy(COMP_functionForMode_C, COMP_functionForMode_C + 4,
+                      functionForMode);
+    rlottie_std::copy(COMP_functionForModeSolid_C, COMP_functionForModeSolid_C + 4,
+                      functionForModeSolid);
+
 #if defined(__ARM_NEON__)
     // update fast path for NEON
     extern void Vcomp_func_solid_SourceOver_neon(
         uint32_t * dest, int length, uint32_t color, uint32_t const_alpha);
 
-    COMP_functionForModeSolid_C[uint(BlendMode::SrcOver)] =
+    functionForModeSolid[uint(BlendMode::SrcOver)] =
         Vcomp_func_solid_SourceOver_neon;
 #endif
 
@@ -938,15 +1290,92 @@ void vInitDrawhelperFunctions()
     extern void Vcomp_func_SourceOver_sse2(uint32_t * dest, const uint32_t *src,
                                           int length, uint32_t const_alpha);
 
-    COMP_functionForModeSolid_C[uint(BlendMode::Src)] =
+    functionForModeSolid[uint(BlendMode::Src)] =
         Vcomp_func_solid_Source_sse2;
-    COMP_functionForModeSolid_C[uint(BlendMode::SrcOver)] =
+    functionForModeSolid[uint(BlendMode::SrcOver)] =
         Vcomp_func_solid_SourceOver_sse2;
 
-    COMP_functionForMode_C[uint(BlendMode::Src)] = Vcomp_func_Source_sse2;
-    // COMP_functionForMode_C[uint(BlendMode::SrcOver)] =
+    functionForMode[uint(BlendMode::Src)] = Vcomp_func_Source_sse2;
+    // functionForMode[uint(BlendMode::SrcOver)] =
     // Vcomp_func_SourceOver_sse2;
 #endif
+
+#if defined(VECTOR_AVX2_DISPATCH)
+    // update fast path for AVX2, when the cpu running us supports it.
+    if (vCpuSupportsAvx2()) {
+        extern void Vcomp_func_solid_Source_avx2(
+            uint32_t * dest, int length, uint32_t color, uint32_t const_alpha);
+        extern void Vcomp_func_solid_SourceOver_avx2(
+            uint32_t * dest, int length, uint32_t color, uint32_t const_alpha);
+        extern void Vcomp_func_solid_DestinationIn_avx2(
+            uint32_t * dest, int length, uint32_t color, uint32_t const_alpha);
+        extern void Vcomp_func_solid_DestinationOut_avx2(
+            uint32_t * dest, int length, uint32_t color, uint32_t const_alpha);
+        extern void Vcomp_func_Source_avx2(uint32_t * dest, const uint32_t *src,
+                                           int length, uint32_t const_alpha);
+        extern void Vcomp_func_SourceOver_avx2(uint32_t * dest, const uint32_t *src,
+                                               int length, uint32_t const_alpha);
+        extern void Vcomp_func_DestinationIn_avx2(
+            uint32_t * dest, const uint32_t *src, int length, uint32_t const_alpha);
+        extern void Vcomp_func_DestinationOut_avx2(
+            uint32_t * dest, const uint32_t *src, int length, uint32_t const_alpha);
+
+        functionForModeSolid[uint(BlendMode::Src)] =
+            Vcomp_func_solid_Source_avx2;
+        functionForModeSolid[uint(BlendMode::SrcOver)] =
+            Vcomp_func_solid_SourceOver_avx2;
+        functionForModeSolid[uint(BlendMode::DestIn)] =
+            Vcomp_func_solid_DestinationIn_avx2;
+        functionForModeSolid[uint(BlendMode::DestOut)] =
+            Vcomp_func_solid_DestinationOut_avx2;
+
+        functionForMode[uint(BlendMode::Src)] = Vcomp_func_Source_avx2;
+        functionForMode[uint(BlendMode::SrcOver)] =
+            Vcomp_func_SourceOver_avx2;
+        functionForMode[uint(BlendMode::DestIn)] =
+            Vcomp_func_DestinationIn_avx2;
+        functionForMode[uint(BlendMode::DestOut)] =
+            Vcomp_func_DestinationOut_avx2;
+
+        extern void Vfetch_gradient_fixed_avx2(
+            uint32_t * buffer, int length, const VGradientData *gradient,
+            int t, int inc);
+        extern void Vfetch_radial_avx2(
+            uint32_t * buffer, uint32_t * end, const Operator *op,
+            const VSpanData *data, float det, float delta_det,
+            float delta_delta_det, float b, float delta_b);
+
+        gradientFixedFetch = Vfetch_gradient_fixed_avx2;
+        gradientRadialFetch = Vfetch_radial_avx2;
+
+        extern void Vfetch_transformed_avx2(
+            uint32_t * buffer, int length, const VBitmapData *bitmap, int x,
+            int y, int fdx, int fdy);
+        extern void Vfetch_transformed_bilinear_avx2(
+            uint32_t * buffer, int length, const VBitmapData *bitmap, int x,
+            int y, int fdx, int fdy);
+
+        textureFetch = Vfetch_transformed_avx2;
+        textureFetchBilinear = Vfetch_transformed_bilinear_avx2;
+
+        extern void Vmask_span_Add_avx2(uchar * dest, int length,
+                                        uint32_t coverage);
+        extern void Vmask_span_Subtract_avx2(uchar * dest, int length,
+                                             uint32_t coverage);
+        extern void Vmask_span_Intersect_avx2(uchar * dest, int length,
+                                              uint32_t coverage);
+        extern void Vmask_span_Difference_avx2(uchar * dest, int length,
+                                               uint32_t coverage);
+
+        maskSpanFunctions[uint(VMaskBuffer::Op::Add)] = Vmask_span_Add_avx2;
+        maskSpanFunctions[uint(VMaskBuffer::Op::Subtract)] =
+            Vmask_span_Subtract_avx2;
+        maskSpanFunctions[uint(VMaskBuffer::Op::Intersect)] =
+            Vmask_span_Intersect_avx2;
+        maskSpanFunctions[uint(VMaskBuffer::Op::Difference)] =
+            Vmask_span_Difference_avx2;
+    }
+#endif
 }
 
 V_CONSTRUCTOR_FUNCTION(vInitDrawhelperFunctions)
@@ -29,6 +29,8 @@
 V_USE_NAMESPACE
 
 struct VSpanData;
+struct VGradientData;
+struct VBitmapData;
 struct Operator;
 
 typedef void (*CompositionFunctionSolid)(uint32_t *dest, int length,
@@ -40,9 +42,35 @@ typedef void (*SourceFetchProc)(uint32_t *buffer, const Operator *o,
                                 int length);
 typedef void (*ProcessRleSpan)(size_t count, const VRle::Span *spans,
                                void *userData);
+typedef void (*GradientFixedFetchProc)(uint32_t *buffer, int length,
+                                       const VGradientData *gradient, int t,
+                                       int inc);
+typedef void (*TextureFetchProc)(uint32_t *buffer, int length,
+                                 const VBitmapData *bitmap, int x, int y,
+                                 int fdx, int fdy);
+typedef void (*GradientRadialFetchProc)(uint32_t *buffer, uint32_t *end,
+                                        const Operator *op,
+                                        const VSpanData *data, float det,
+                                        float delta_det, float delta_delta_det,
+                                        float b, float delta_b);
+typedef void (*MaskSpanFunction)(uchar *dest, int length, uint32_t coverage);
 
 extern void memfill32(uint32_t *dest, uint32_t value, int count);
 
+/*
+ * x86 builds carry AVX2 versions of the composition functions which are
+ * selected at runtime (@see vdrawhelper_avx2.cpp).
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_AVX2_DISPATCH
+extern bool vCpuSupportsAvx2();
+#endif
+
+// fixed point gradient positions
+#define FIXPT_BITS 8
+#define FIXPT_SIZE (1 << FIXPT_BITS)
+
 struct LinearGradientValues {
     float dx;
     float dy;
@@ -100,6 +128,36 @@ private:
     bool      mNeedClear{true};
 };
 
+/*
+ * Alpha8 buffer to combine rles on, one coverage byte per pixel.
+ * The ops give the same coverage as the VRle ops (+, -, &, ^) but cost the
+ * length of the spans instead of merging span lists, which is cheaper when
+ * many rles with many spans are combined.
+ */
+class VMaskBuffer {
+public:
+    enum class Op { Add, Subtract, Intersect, Difference };
+
+    void  reset(const VRect &rect, uchar value = 0);
+    void  compose(const VRle &rle, Op op);
+    bool  empty() const;
+    VRle  toRle() const;
+    const VRect &rect() const { return mRect; }
+
+private:
+    uchar *scanLine(int y) const { return mData + size_t(y) * mStride; }
+    void   clearTill(int x, int y);
+    static void composeSpans(size_t count, const VRle::Span *spans,
+                             void *userData);
+
+    VRect                      mRect;
+    VBitmapPool::Bitmap        mBitmap; // Alpha8 scratch from the pool
+    uchar                     *mData{nullptr};
+    size_t                     mStride{0};
+    VPoint                     mCursor; // next pixel the rle didn't cover
+    Op                         mOp{Op::Add};
+};
+
 struct VGradientData {
     VGradient::Spread mSpread;
     struct Linear{
@@ -131,6 +189,7 @@ struct VBitmapData
     uint bytesPerLine;
     VBitmap::Format format;
     bool hasAlpha;
+    bool smooth;
     enum Type {
         Plain,
         Tiled
@@ -155,15 +214,21 @@ struct VSpanData {
                 int                       alpha = 255);
     void  setupMatrix(const VMatrix &matrix);
 
-    VRect clipRect() const
-    {
-        return VRect(0, 0, mDrawableSize.width(), mDrawableSize.height());
-    }
+    VRect clipRect() const { return mClip; }
 
     void setDrawRegion(const VRect &region)
     {
         mOffset = VPoint(region.left(), region.top());
         mDrawableSize = VSize(region.width(), region.height());
+        mClip = VRect(0, 0, mDrawableSize.width(), mDrawableSize.height());
+        updateSpanFunc();
+    }
+
+    // restricts the drawing to a part of the subsurface.
+    void setClipRect(const VRect &clip)
+    {
+        mClip = clip & VRect(0, 0, mDrawableSize.width(), mDrawableSize.height());
+        updateSpanFunc();
     }
 
     uint *buffer(int x, int y) const
@@ -180,6 +245,7 @@ struct VSpanData {
     rlottie_std::shared_ptr<const VColorTable>   mColorTable{nullptr};
     VPoint                               mOffset; // offset to the subsurface
     VSize                                mDrawableSize;// suburface size
+    VRect                                mClip; // clip rect in the subsurface
     union {
         uint32_t      mSolid;
         VGradientData mGradient;
@@ -228,6 +294,18 @@ static inline uint INTERPOLATE_PIXEL_255(uint x, uint a, uint y, uint b)
     return x;
 }
 
+// x * a + y * b where a + b = 256
+static inline uint INTERPOLATE_PIXEL_256(uint x, uint a, uint y, uint b)
+{
+    uint t = (x & 0xff00ff) * a + (y & 0xff00ff) * b;
+    t >>= 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a + ((y >> 8) & 0xff00ff) * b;
+    x &= 0xff00ff00;
+    x |= t;
+    return x;
+}
+
 #define LOOP_ALIGNED_U1_A4(DEST, LENGTH, UOP, A4OP) \
     {                                               \
         while ((uintptr_t)DEST & 0xF && LENGTH)     \
@@ -0,0 +1,627 @@
+/* 
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd. All rights reserved.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "vdrawhelper.h"
+
+#if defined(VECTOR_AVX2_DISPATCH)
+
+#include <immintrin.h> /* for AVX2 intrinsics */
+
+/*
+ * AVX2 versions of the composition functions and of the gradient and
+ * texture span fetchers, 8 pixels per iteration, and of the Alpha8 mask
+ * span functions.
+ * This file is compiled for the baseline target and every function is
+ * tagged with the avx2 target attribute, vInitDrawhelperFunctions() only
+ * installs them when the cpu supports AVX2.
+ * The results are bit exact with the C versions in
+ * vcompositionfunctions.cpp and vdrawhelper.cpp, the remaining pixels of a
+ * span are handled with the same scalar code.
+ */
+
+#define V_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Each 32bits components of alpha must be in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_byte_mul_avx2(__m256i c, __m256i a)
+{
+    const __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    /* for AG */
+    __m256i v_ag = _mm256_and_si256(ag_mask, c);
+    v_ag = _mm256_srli_epi32(v_ag, 8);
+    v_ag = _mm256_mullo_epi16(a, v_ag);
+    v_ag = _mm256_and_si256(ag_mask, v_ag);
+
+    /* for RB */
+    __m256i v_rb = _mm256_and_si256(rb_mask, c);
+    v_rb = _mm256_mullo_epi16(a, v_rb);
+    v_rb = _mm256_srli_epi32(v_rb, 8);
+    v_rb = _mm256_and_si256(rb_mask, v_rb);
+
+    /* combine */
+    return _mm256_add_epi32(v_ag, v_rb);
+}
+
+// alpha of each pixel in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_alpha_avx2(__m256i c)
+{
+    __m256i a = _mm256_srli_epi32(c, 24);
+    return _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+}
+
+// inverse alpha of each pixel in the form 0x00AA00AA
+V_TARGET_AVX2 static inline __m256i v8_ialpha_avx2(__m256i c)
+{
+    return v8_alpha_avx2(_mm256_xor_si256(c, _mm256_set1_epi32(-1)));
+}
+
+// x * a + y * b where a + b <= 256
+V_TARGET_AVX2 static inline __m256i v8_interpolate_avx2(__m256i x, __m256i a,
+                                                       __m256i y, __m256i b)
+{
+    const __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    __m256i v_rb = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_and_si256(x, rb_mask), a),
+        _mm256_mullo_epi16(_mm256_and_si256(y, rb_mask), b));
+    v_rb = _mm256_and_si256(_mm256_srli_epi32(v_rb, 8), rb_mask);
+
+    __m256i v_ag = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(x, 8), rb_mask), a),
+        _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(y, 8), rb_mask), b));
+    v_ag = _mm256_and_si256(v_ag, ag_mask);
+
+    return _mm256_or_si256(v_ag, v_rb);
+}
+
+#define V8_LOAD(ptr) _mm256_loadu_si256((const __m256i *)(ptr))
+#define V8_STORE(ptr, v) _mm256_storeu_si256((__m256i *)(ptr), v)
+
+V_TARGET_AVX2 static void memfill32_avx2(uint32_t *dest, uint32_t value,
+                                         int length)
+{
+    const __m256i v_value = _mm256_set1_epi32(int(value));
+
+    for (; length >= 8; length -= 8, dest += 8) V8_STORE(dest, v_value);
+    for (; length > 0; length--) *dest++ = value;
+}
+
+// dest = color + (dest * alpha)
+V_TARGET_AVX2 static void comp_func_helper_avx2(uint32_t *dest, int length,
+                                                uint32_t color, uint32_t alpha)
+{
+    const __m256i v_color = _mm256_set1_epi32(int(color));
+    const __m256i v_a = _mm256_set1_epi32(int(alpha | (alpha << 16)));
+
+    for (; length >= 8; length -= 8, dest += 8) {
+        __m256i v_dest = v8_byte_mul_avx2(V8_LOAD(dest), v_a);
+        V8_STORE(dest, _mm256_add_epi32(v_dest, v_color));
+    }
+    for (; length > 0; length--, dest++) *dest = color + BYTE_MUL(*dest, alpha);
+}
+
+// dest = dest * alpha
+V_TARGET_AVX2 static void comp_func_mul_helper_avx2(uint32_t *dest, int length,
+                                                    uint32_t alpha)
+{
+    const __m256i v_a = _mm256_set1_epi32(int(alpha | (alpha << 16)));
+
+    for (; length >= 8; length -= 8, dest += 8)
+        V8_STORE(dest, v8_byte_mul_avx2(V8_LOAD(dest), v_a));
+    for (; length > 0; length--, dest++) *dest = BYTE_MUL(*dest, alpha);
+}
+
+V_TARGET_AVX2 void Vcomp_func_solid_Source_avx2(uint32_t *dest, int length,
+                                                uint32_t color,
+                                                uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        memfill32_avx2(dest, color, length);
+    } else {
+        color = BYTE_MUL(color, const_alpha);
+        comp_func_helper_avx2(dest, length, color, 255 - const_alpha);
+    }
+}
+
+V_TARGET_AVX2 void Vcomp_func_solid_SourceOver_avx2(uint32_t *dest, int length,
+                                                    uint32_t color,
+                                                    uint32_t const_alpha)
+{
+    if (const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+    comp_func_helper_avx2(dest, length, color, 255 - vAlpha(color));
+}
+
+V_TARGET_AVX2 void Vcomp_func_solid_DestinationIn_avx2(uint32_t *dest,
+                                                       int       length,
+                                                       uint32_t  color,
+                                                       uint32_t  const_alpha)
+{
+    uint32_t a = vAlpha(color);
+    if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    comp_func_mul_helper_avx2(dest, length, a);
+}
+
+V_TARGET_AVX2 void Vcomp_func_solid_DestinationOut_avx2(uint32_t *dest,
+                                                        int       length,
+                                                        uint32_t  color,
+                                                        uint32_t  const_alpha)
+{
+    uint32_t a = vAlpha(~color);
+    if (const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    comp_func_mul_helper_avx2(dest, length, a);
+}
+
+V_TARGET_AVX2 void Vcomp_func_Source_avx2(uint32_t *dest, const uint32_t *src,
+                                          int length, uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        memcpy(dest, src, size_t(length) * sizeof(uint32_t));
+        return;
+    }
+
+    uint32_t      ialpha = 255 - const_alpha;
+    const __m256i v_a = _mm256_set1_epi32(int(const_alpha | (const_alpha << 16)));
+    const __m256i v_ia = _mm256_set1_epi32(int(ialpha | (ialpha << 16)));
+
+    for (; length >= 8; length -= 8, dest += 8, src += 8) {
+        V8_STORE(dest, v8_interpolate_avx2(V8_LOAD(src), v_a, V8_LOAD(dest), v_ia));
+    }
+    for (; length > 0; length--, dest++, src++)
+        *dest = INTERPOLATE_PIXEL_255(*src, const_alpha, *dest, ialpha);
+}
+
+V_TARGET_AVX2 void Vcomp_func_SourceOver_avx2(uint32_t *dest, const uint32_t *src,
+                                              int length, uint32_t const_alpha)
+{
+    uint32_t s, sia;
+
+    if (const_alpha == 255) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i opaque = _mm256_set1_epi32(int(0xff000000));
+
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            __m256i v_src = V8_LOAD(src);
+            // transparent pixels leave dest untouched.
+            __m256i v_keep = _mm256_cmpeq_epi32(v_src, zero);
+            if (_mm256_movemask_epi8(v_keep) == -1) continue;
+            // opaque pixels replace dest.
+            __m256i v_opaque = _mm256_cmpeq_epi32(_mm256_and_si256(v_src, opaque), opaque);
+            if (_mm256_movemask_epi8(v_opaque) == -1) {
+                V8_STORE(dest, v_src);
+                continue;
+            }
+            __m256i v_dest = V8_LOAD(dest);
+            __m256i v_result = _mm256_add_epi32(
+                v_src, v8_byte_mul_avx2(v_dest, v8_ialpha_avx2(v_src)));
+            v_result = _mm256_blendv_epi8(v_result, v_src, v_opaque);
+            v_result = _mm256_blendv_epi8(v_result, v_dest, v_keep);
+            V8_STORE(dest, v_result);
+        }
+        for (; length > 0; length--, dest++, src++) {
+            s = *src;
+            if (s >= 0xff000000)
+                *dest = s;
+            else if (s != 0) {
+                sia = vAlpha(~s);
+                *dest = s + BYTE_MUL(*dest, sia);
+            }
+        }
+    } else {
+        const __m256i v_a = _mm256_set1_epi32(int(const_alpha | (const_alpha << 16)));
+
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            __m256i v_src = v8_byte_mul_avx2(V8_LOAD(src), v_a);
+            __m256i v_dest = v8_byte_mul_avx2(V8_LOAD(dest), v8_ialpha_avx2(v_src));
+            V8_STORE(dest, _mm256_add_epi32(v_src, v_dest));
+        }
+        for (; length > 0; length--, dest++, src++) {
+            s = BYTE_MUL(*src, const_alpha);
+            sia = vAlpha(~s);
+            *dest = s + BYTE_MUL(*dest, sia);
+        }
+    }
+}
+
+// alpha' = (alpha * const_alpha) / 256 + (255 - const_alpha)
+V_TARGET_AVX2 static inline __m256i v8_const_alpha_avx2(__m256i a, __m256i v_ca,
+                                                       __m256i v_cia)
+{
+    a = _mm256_srli_epi32(_mm256_mullo_epi16(a, v_ca), 8);
+    a = _mm256_add_epi32(_mm256_and_si256(a, _mm256_set1_epi32(0x00FF00FF)), v_cia);
+    return a;
+}
+
+V_TARGET_AVX2 void Vcomp_func_DestinationIn_avx2(uint32_t *dest, const uint32_t *src,
+                                                 int length, uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            V8_STORE(dest, v8_byte_mul_avx2(V8_LOAD(dest), v8_alpha_avx2(V8_LOAD(src))));
+        }
+        for (; length > 0; length--, dest++, src++)
+            *dest = BYTE_MUL(*dest, vAlpha(*src));
+    } else {
+        uint32_t      cia = 255 - const_alpha;
+        const __m256i v_ca = _mm256_set1_epi32(int(const_alpha | (const_alpha << 16)));
+        const __m256i v_cia = _mm256_set1_epi32(int(cia | (cia << 16)));
+
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            __m256i a = v8_const_alpha_avx2(v8_alpha_avx2(V8_LOAD(src)), v_ca, v_cia);
+            V8_STORE(dest, v8_byte_mul_avx2(V8_LOAD(dest), a));
+        }
+        for (; length > 0; length--, dest++, src++) {
+            uint32_t a = BYTE_MUL(vAlpha(*src), const_alpha) + cia;
+            *dest = BYTE_MUL(*dest, a);
+        }
+    }
+}
+
+V_TARGET_AVX2 void Vcomp_func_DestinationOut_avx2(uint32_t *dest, const uint32_t *src,
+                                                  int length, uint32_t const_alpha)
+{
+    if (const_alpha == 255) {
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            V8_STORE(dest, v8_byte_mul_avx2(V8_LOAD(dest), v8_ialpha_avx2(V8_LOAD(src))));
+        }
+        for (; length > 0; length--, dest++, src++)
+            *dest = BYTE_MUL(*dest, vAlpha(~*src));
+    } else {
+        uint32_t      cia = 255 - const_alpha;
+        const __m256i v_ca = _mm256_set1_epi32(int(const_alpha | (const_alpha << 16)));
+        const __m256i v_cia = _mm256_set1_epi32(int(cia | (cia << 16)));
+
+        for (; length >= 8; length -= 8, dest += 8, src += 8) {
+            __m256i a = v8_const_alpha_avx2(v8_ialpha_avx2(V8_LOAD(src)), v_ca, v_cia);
+            V8_STORE(dest, v8_byte_mul_avx2(V8_LOAD(dest), a));
+        }
+        for (; length > 0; length--, dest++, src++) {
+            uint32_t sia = BYTE_MUL(vAlpha(~*src), const_alpha) + cia;
+            *dest = BYTE_MUL(*dest, sia);
+        }
+    }
+}
+
+/*
+ * Gradient span fetchers, 8 color table lookups per iteration.
+ * They follow gradientPixelFixed() / gradientPixel() in vdrawhelper.cpp
+ * exactly, so the vector and scalar paths pick the same colors.
+ */
+V_TARGET_AVX2 static inline __m256i v8_gradient_clamp_avx2(
+    const VGradientData *grad, __m256i ipos)
+{
+    const int size = VGradient::colorTableSize;
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        return _mm256_and_si256(ipos, _mm256_set1_epi32(size - 1));
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        ipos = _mm256_and_si256(ipos, _mm256_set1_epi32(2 * size - 1));
+        return _mm256_min_epi32(ipos, _mm256_sub_epi32(
+                                          _mm256_set1_epi32(2 * size - 1), ipos));
+    }
+    ipos = _mm256_max_epi32(ipos, _mm256_setzero_si256());
+    return _mm256_min_epi32(ipos, _mm256_set1_epi32(size - 1));
+}
+
+V_TARGET_AVX2 static inline __m256i v8_gradient_pixel_avx2(
+    const VGradientData *grad, __m256 pos)
+{
+    pos = _mm256_mul_ps(pos, _mm256_set1_ps(float(VGradient::colorTableSize - 1)));
+    pos = _mm256_add_ps(pos, _mm256_set1_ps(0.5f));
+    __m256i ipos = v8_gradient_clamp_avx2(grad, _mm256_cvttps_epi32(pos));
+    return _mm256_i32gather_epi32(reinterpret_cast<const int *>(grad->mColorTable),
+                                  ipos, 4);
+}
+
+// stores the first length (< 8) pixels of v to buffer.
+V_TARGET_AVX2 static inline void v8_store_partial_avx2(uint32_t *buffer,
+                                                       __m256i v, int length)
+{
+    alignas(32) uint32_t tmp[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(tmp), v);
+    memcpy(buffer, tmp, size_t(length) * sizeof(uint32_t));
+}
+
+V_TARGET_AVX2 void Vfetch_gradient_fixed_avx2(uint32_t *buffer, int length,
+                                              const VGradientData *grad, int t,
+                                              int inc)
+{
+    const __m256i v_inc = _mm256_set1_epi32(inc * 8);
+    const __m256i v_half = _mm256_set1_epi32(FIXPT_SIZE / 2);
+    __m256i v_t = _mm256_add_epi32(
+        _mm256_set1_epi32(t),
+        _mm256_mullo_epi32(_mm256_set1_epi32(inc),
+                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+
+    while (length > 0) {
+        __m256i ipos = _mm256_srai_epi32(_mm256_add_epi32(v_t, v_half), FIXPT_BITS);
+        ipos = v8_gradient_clamp_avx2(grad, ipos);
+        __m256i color = _mm256_i32gather_epi32(
+            reinterpret_cast<const int *>(grad->mColorTable), ipos, 4);
+        if (length >= 8)
+            V8_STORE(buffer, color);
+        else
+            v8_store_partial_avx2(buffer, color, length);
+        v_t = _mm256_add_epi32(v_t, v_inc);
+        buffer += 8;
+        length -= 8;
+    }
+}
+
+V_TARGET_AVX2 void Vfetch_radial_avx2(uint32_t *buffer, uint32_t *end,
+                                      const Operator *op, const VSpanData *data,
+                                      float det, float delta_det,
+                                      float delta_delta_det, float b,
+                                      float delta_b)
+{
+    const VGradientData *grad = &data->mGradient;
+    const __m256         v_zero = _mm256_setzero_ps();
+    const __m256         v_fr = _mm256_set1_ps(grad->radial.fradius);
+    const __m256         v_dr = _mm256_set1_ps(op->radial.dr);
+    alignas(32) float    dets[8], bs[8];
+    int                  length = int(end - buffer);
+
+    while (length > 0) {
+        // the same incremental evaluation as the scalar fetcher.
+        for (int i = 0; i < 8; i++) {
+            dets[i] = det;
+            bs[i] = b;
+            det += delta_det;
+            delta_det += delta_delta_det;
+            b += delta_b;
+        }
+        __m256 v_det = _mm256_load_ps(dets);
+        __m256 w = _mm256_sub_ps(_mm256_sqrt_ps(v_det), _mm256_load_ps(bs));
+        __m256i color = v8_gradient_pixel_avx2(grad, w);
+
+        if (op->radial.extended) {
+            __m256 valid = _mm256_cmp_ps(v_det, v_zero, _CMP_GE_OQ);
+            __m256 radius = _mm256_add_ps(v_fr, _mm256_mul_ps(v_dr, w));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(radius, v_zero, _CMP_GE_OQ));
+            color = _mm256_and_si256(color, _mm256_castps_si256(valid));
+        }
+
+        if (length >= 8)
+            V8_STORE(buffer, color);
+        else
+            v8_store_partial_avx2(buffer, color, length);
+        buffer += 8;
+        length -= 8;
+    }
+}
+
+/*
+ * Texture span fetchers, they follow fetch_transformed() and
+ * fetch_transformed_bilinear() in vdrawhelper.cpp.
+ */
+// 16.16 fixed point positions of the next 8 pixels.
+V_TARGET_AVX2 static inline __m256i v8_fixed_ramp_avx2(int v, int inc)
+{
+    return _mm256_add_epi32(
+        _mm256_set1_epi32(v),
+        _mm256_mullo_epi32(_mm256_set1_epi32(inc),
+                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+}
+
+// byte offset of the clamped pixel position (px, py) in the bitmap.
+V_TARGET_AVX2 static inline __m256i v8_texel_offset_avx2(__m256i px,
+                                                         __m256i py,
+                                                         __m256i v_bpl)
+{
+    return _mm256_add_epi32(_mm256_mullo_epi32(py, v_bpl),
+                            _mm256_slli_epi32(px, 2));
+}
+
+V_TARGET_AVX2 static inline __m256i v8_clamp_avx2(__m256i v, __m256i lo,
+                                                  __m256i hi)
+{
+    return _mm256_min_epi32(_mm256_max_epi32(v, lo), hi);
+}
+
+V_TARGET_AVX2 void Vfetch_transformed_avx2(uint32_t *buffer, int length,
+                                           const VBitmapData *bitmap, int x,
+                                           int y, int fdx, int fdy)
+{
+    const int *    data = reinterpret_cast<const int *>(bitmap->imageData);
+    const __m256i v_x1 = _mm256_set1_epi32(bitmap->x1);
+    const __m256i v_y1 = _mm256_set1_epi32(bitmap->y1);
+    const __m256i v_x2 = _mm256_set1_epi32(bitmap->x2 - 1);
+    const __m256i v_y2 = _mm256_set1_epi32(bitmap->y2 - 1);
+    const __m256i v_bpl = _mm256_set1_epi32(int(bitmap->bytesPerLine));
+    const __m256i v_fdx = _mm256_set1_epi32(fdx * 8);
+    const __m256i v_fdy = _mm256_set1_epi32(fdy * 8);
+    __m256i       v_x = v8_fixed_ramp_avx2(x, fdx);
+    __m256i       v_y = v8_fixed_ramp_avx2(y, fdy);
+
+    while (length > 0) {
+        __m256i px = v8_clamp_avx2(_mm256_srai_epi32(v_x, 16), v_x1, v_x2);
+        __m256i py = v8_clamp_avx2(_mm256_srai_epi32(v_y, 16), v_y1, v_y2);
+        __m256i color = _mm256_i32gather_epi32(
+            data, v8_texel_offset_avx2(px, py, v_bpl), 1);
+        if (length >= 8)
+            V8_STORE(buffer, color);
+        else
+            v8_store_partial_avx2(buffer, color, length);
+        v_x = _mm256_add_epi32(v_x, v_fdx);
+        v_y = _mm256_add_epi32(v_y, v_fdy);
+        buffer += 8;
+        length -= 8;
+    }
+}
+
+V_TARGET_AVX2 void Vfetch_transformed_bilinear_avx2(uint32_t *buffer,
+                                                    int length,
+                                                    const VBitmapData *bitmap,
+                                                    int x, int y, int fdx,
+                                                    int fdy)
+{
+    const int *    data = reinterpret_cast<const int *>(bitmap->imageData);
+    const __m256i v_x1 = _mm256_set1_epi32(bitmap->x1);
+    const __m256i v_y1 = _mm256_set1_epi32(bitmap->y1);
+    const __m256i v_x2 = _mm256_set1_epi32(bitmap->x2 - 1);
+    const __m256i v_y2 = _mm256_set1_epi32(bitmap->y2 - 1);
+    const __m256i v_bpl = _mm256_set1_epi32(int(bitmap->bytesPerLine));
+    const __m256i v_fdx = _mm256_set1_epi32(fdx * 8);
+    const __m256i v_fdy = _mm256_set1_epi32(fdy * 8);
+    const __m256i v_one = _mm256_set1_epi32(1);
+    const __m256i v_256 = _mm256_set1_epi32(0x01000100);
+    const __m256i v_dist_mask = _mm256_set1_epi32(0xff);
+    __m256i       v_x = v8_fixed_ramp_avx2(x, fdx);
+    __m256i       v_y = v8_fixed_ramp_avx2(y, fdy);
+
+    while (length > 0) {
+        __m256i ix = _mm256_srai_epi32(v_x, 16);
+        __m256i iy = _mm256_srai_epi32(v_y, 16);
+        // weights in the form 0x00WW00WW, 256 - w can reach 0x01000100.
+        __m256i distx = _mm256_and_si256(_mm256_srli_epi32(v_x, 8), v_dist_mask);
+        __m256i disty = _mm256_and_si256(_mm256_srli_epi32(v_y, 8), v_dist_mask);
+        distx = _mm256_or_si256(distx, _mm256_slli_epi32(distx, 16));
+        disty = _mm256_or_si256(disty, _mm256_slli_epi32(disty, 16));
+        __m256i idistx = _mm256_sub_epi16(v_256, distx);
+        __m256i idisty = _mm256_sub_epi16(v_256, disty);
+
+        __m256i x1 = v8_clamp_avx2(ix, v_x1, v_x2);
+        __m256i x2 = v8_clamp_avx2(_mm256_add_epi32(ix, v_one), v_x1, v_x2);
+        __m256i y1 = v8_clamp_avx2(iy, v_y1, v_y2);
+        __m256i y2 = v8_clamp_avx2(_mm256_add_epi32(iy, v_one), v_y1, v_y2);
+
+        __m256i tl = _mm256_i32gather_epi32(
+            data, v8_texel_offset_avx2(x1, y1, v_bpl), 1);
+        __m256i tr = _mm256_i32gather_epi32(
+            data, v8_texel_offset_avx2(x2, y1, v_bpl), 1);
+        __m256i bl = _mm256_i32gather_epi32(
+            data, v8_texel_offset_avx2(x1, y2, v_bpl), 1);
+        __m256i br = _mm256_i32gather_epi32(
+            data, v8_texel_offset_avx2(x2, y2, v_bpl), 1);
+
+        __m256i top = v8_interpolate_avx2(tl, idistx, tr, distx);
+        __m256i bottom = v8_interpolate_avx2(bl, idistx, br, distx);
+        __m256i color = v8_interpolate_avx2(top, idisty, bottom, disty);
+
+        if (length >= 8)
+            V8_STORE(buffer, color);
+        else
+            v8_store_partial_avx2(buffer, color, length);
+        v_x = _mm256_add_epi32(v_x, v_fdx);
+        v_y = _mm256_add_epi32(v_y, v_fdy);
+        buffer += 8;
+        length -= 8;
+    }
+}
+
+/*
+ * Alpha8 mask span functions, 32 coverage bytes per iteration computed in
+ * 16 bit lanes. The formulas follow the C versions in vdrawhelper.cpp.
+ */
+static inline uchar mask_div_255(int x)
+{
+    return uchar((x + (x >> 8) + 0x80) >> 8);
+}
+
+V_TARGET_AVX2 static inline __m256i v16_div_255_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_srli_epi16(x, 8));
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(x, 8);
+}
+
+V_TARGET_AVX2 static inline __m256i v16_mul_avx2(__m256i x, __m256i c)
+{
+    return v16_div_255_avx2(_mm256_mullo_epi16(x, c));
+}
+
+V_TARGET_AVX2 void Vmask_span_Add_avx2(uchar *dest, int length,
+                                       uint32_t coverage)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i v_c = _mm256_set1_epi16(short(coverage));
+    const __m256i v_ic = _mm256_set1_epi16(short(255 - coverage));
+
+    for (; length >= 32; length -= 32, dest += 32) {
+        __m256i d = V8_LOAD(dest);
+        __m256i lo = _mm256_unpacklo_epi8(d, zero);
+        __m256i hi = _mm256_unpackhi_epi8(d, zero);
+        lo = _mm256_add_epi16(v_c, v16_mul_avx2(lo, v_ic));
+        hi = _mm256_add_epi16(v_c, v16_mul_avx2(hi, v_ic));
+        V8_STORE(dest, _mm256_packus_epi16(lo, hi));
+    }
+    for (int i = 0; i < length; i++)
+        dest[i] = uchar(coverage + mask_div_255(int(255 - coverage) * dest[i]));
+}
+
+V_TARGET_AVX2 static void mask_span_mul_avx2(uchar *dest, int length,
+                                             uint32_t factor)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i v_f = _mm256_set1_epi16(short(factor));
+
+    for (; length >= 32; length -= 32, dest += 32) {
+        __m256i d = V8_LOAD(dest);
+        __m256i lo = v16_mul_avx2(_mm256_unpacklo_epi8(d, zero), v_f);
+        __m256i hi = v16_mul_avx2(_mm256_unpackhi_epi8(d, zero), v_f);
+        V8_STORE(dest, _mm256_packus_epi16(lo, hi));
+    }
+    for (int i = 0; i < length; i++)
+        dest[i] = mask_div_255(int(factor) * dest[i]);
+}
+
+V_TARGET_AVX2 void Vmask_span_Subtract_avx2(uchar *dest, int length,
+                                            uint32_t coverage)
+{
+    mask_span_mul_avx2(dest, length, 255 - coverage);
+}
+
+V_TARGET_AVX2 void Vmask_span_Intersect_avx2(uchar *dest, int length,
+                                             uint32_t coverage)
+{
+    mask_span_mul_avx2(dest, length, coverage);
+}
+
+V_TARGET_AVX2 void Vmask_span_Difference_avx2(uchar *dest, int length,
+                                              uint32_t coverage)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i v_255 = _mm256_set1_epi16(255);
+    const __m256i v_c = _mm256_set1_epi16(short(coverage));
+    const __m256i v_ic = _mm256_set1_epi16(short(255 - coverage));
+
+    for (; length >= 32; length -= 32, dest += 32) {
+        __m256i d = V8_LOAD(dest);
+        __m256i lo = _mm256_unpacklo_epi8(d, zero);
+        __m256i hi = _mm256_unpackhi_epi8(d, zero);
+        // (255 - c) * d + c * (255 - d) stays below 2^16.
+        lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, v_ic),
+                              _mm256_mullo_epi16(_mm256_sub_epi16(v_255, lo), v_c));
+        hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, v_ic),
+                              _mm256_mullo_epi16(_mm256_sub_epi16(v_255, hi), v_c));
+        V8_STORE(dest, _mm256_packus_epi16(v16_div_255_avx2(lo),
+                                           v16_div_255_avx2(hi)));
+    }
+    const int c = int(coverage);
+    for (int i = 0; i < length; i++)
+        dest[i] = mask_div_255((255 - c) * dest[i] + c * (255 - dest[i]));
+}
+
+bool vCpuSupportsAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
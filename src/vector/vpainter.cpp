@@ -37,17 +37,18 @@ void VPainter::drawRle(const VRle &rle, const VRle &clip)
 {
     if (rle.empty() || clip.empty()) return;
 
-    if (!mSpanData.mUnclippedBlendFunc) return;
+    if (!mSpanData.mBlendFunc) return;
 
-    rle.intersect(clip, mSpanData.mUnclippedBlendFunc, &mSpanData);
+    rle.intersect(clip, mSpanData.mBlendFunc, &mSpanData);
 }
 
 static void fillRect(const VRect &r, VSpanData *data)
 {
-    auto x1 = rlottie_std::max(r.x(), 0);
-    auto x2 = rlottie_std::min(r.x() + r.width(), data->mDrawableSize.width());
-    auto y1 = rlottie_std::max(r.y(), 0);
-    auto y2 = rlottie_std::min(r.y() + r.height(), data->mDrawableSize.height());
+    const VRect clip = data->clipRect();
+    auto x1 = rlottie_std::max(r.x(), clip.left());
+    auto x2 = rlottie_std::min(r.x() + r.width(), clip.right());
+    auto y1 = rlottie_std::max(r.y(), clip.top());
+    auto y2 = rlottie_std::min(r.y() + r.height(), clip.bottom());
 
     if (x2 <= x1 || y2 <= y1) return;
 
@@ -105,6 +106,11 @@ void VPainter::setDrawRegion(const VRect &region)
     mSpanData.setDrawRegion(region);
 }
 
+void VPainter::setClipRect(const VRect &clip)
+{
+    mSpanData.setClipRect(clip);
+}
+
 void VPainter::setBrush(const VBrush &brush)
 {
     mSpanData.setup(brush);
@@ -120,6 +126,11 @@ VRect VPainter::clipBoundingRect() const
     return mSpanData.clipRect();
 }
 
+VRect VPainter::drawRegion() const
+{
+    return VRect(mSpanData.mOffset, mSpanData.mDrawableSize);
+}
+
 void VPainter::drawBitmap(const VPoint &point, const VBitmap &bitmap,
                           const VRect &source, uint8_t const_alpha)
 {
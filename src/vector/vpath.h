@@ -70,6 +70,7 @@ public:
     void  clone(const VPath &srcPath);
     bool unique() const { return d.unique();}
     size_t refCount() const { return d.refCount();}
+    bool sharedWith(const VPath &path) const { return &d.read() == &path.d.read();}
 
 private:
     struct VPathData {
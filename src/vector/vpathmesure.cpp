@@ -17,46 +17,160 @@
  */
 
 #include "vpathmesure.h"
+#include <algorithm>
 #include "vbezier.h"
-#include "vdasher.h"
+#include "vline.h"
 
 V_BEGIN_NAMESPACE
 
+void VPathMesure::setStart(float start)
+{
+    if (!vCompare(mStart, start)) mResultDirty = true;
+    mStart = start;
+}
+
+void VPathMesure::setEnd(float end)
+{
+    if (!vCompare(mEnd, end)) mResultDirty = true;
+    mEnd = end;
+}
+
+void VPathMesure::setPath(const VPath &path)
+{
+    if (mPath.sharedWith(path)) return;
+
+    mPath = path;
+    mResultDirty = true;
+    mSegments.clear();
+    mContours.clear();
+    mLength = 0.0f;
+
+    const rlottie_std::vector<VPath::Element> &elms = path.elements();
+    const rlottie_std::vector<VPointF> &       pts = path.points();
+
+    uint32_t i = 0;
+    for (auto e : elms) {
+        switch (e) {
+        case VPath::Element::MoveTo:
+            mContours.push_back({mSegments.size(), mSegments.size(), 0.0f});
+            i++;
+            break;
+        case VPath::Element::LineTo: {
+            float len = VLine(pts[i - 1], pts[i]).length();
+            mLength += len;
+            mContours.back().length += len;
+            mSegments.push_back({mContours.back().length, i - 1, false});
+            mContours.back().last = mSegments.size();
+            i++;
+            break;
+        }
+        case VPath::Element::CubicTo: {
+            float len = VBezier::fromPoints(pts[i - 1], pts[i], pts[i + 1],
+                                            pts[i + 2])
+                            .length();
+            mLength += len;
+            mContours.back().length += len;
+            mSegments.push_back({mContours.back().length, i - 1, true});
+            mContours.back().last = mSegments.size();
+            i += 3;
+            break;
+        }
+        case VPath::Element::Close:
+            // The point is already joined to start point in VPath
+            // no need to do anything here.
+            break;
+        }
+    }
+}
+
+/*
+ * Appends the part of the contour between the length from and to.
+ * The first segment is found with a binary search on the length table,
+ * only the first and the last segment need to be split.
+ */
+void VPathMesure::addSegment(const Contour &contour, float from, float to)
+{
+    to = rlottie_std::min(to, contour.length);
+    if (to <= from) return;
+
+    auto first = mSegments.cbegin() + contour.first;
+    auto last = mSegments.cbegin() + contour.last;
+    auto it = rlottie_std::upper_bound(
+        first, last, from,
+        [](float len, const Segment &segment) { return len < segment.end; });
+
+    const VPointF *pts = mPath.points().data();
+    float          segStart = (it == first) ? 0.0f : (it - 1)->end;
+    bool           moveTo = true;
+
+    for (; it != last && segStart < to; ++it) {
+        float          segLen = it->end - segStart;
+        float          a = rlottie_std::max(from - segStart, 0.0f);
+        float          b = rlottie_std::min(to - segStart, segLen);
+        const VPointF *p = pts + it->point;
+
+        if (it->cubic) {
+            VBezier bez = VBezier::fromPoints(p[0], p[1], p[2], p[3]);
+            VBezier tmp;
+            if (a > 0.0f) bez.splitAtLength(a, &tmp, &bez);
+            if (b < segLen) bez.splitAtLength(b - a, &bez, &tmp);
+            if (moveTo) mScratchObject.moveTo(bez.pt1());
+            mScratchObject.cubicTo(bez.pt2(), bez.pt3(), bez.pt4());
+        } else {
+            VPointF d = p[1] - p[0];
+            if (moveTo)
+                mScratchObject.moveTo(a > 0.0f ? p[0] + d * (a / segLen)
+                                               : p[0]);
+            mScratchObject.lineTo(b < segLen ? p[0] + d * (b / segLen) : p[1]);
+        }
+        moveTo = false;
+        segStart = it->end;
+    }
+}
+
 /*
  * start and end value must be normalized to [0 - 1]
  * Path mesure trims the path from [start --> end]
  * if start > end it treates as a loop and trims as two segment
  *  [0-->end] and [start --> 1]
+ * like the dasher, every contour is trimmed from its own start point
+ * with the length of the whole path.
  */
-VPath VPathMesure::trim(const VPath &path)
+VPath VPathMesure::trim()
 {
     if (vCompare(mStart, mEnd)) return VPath();
 
     if ((vCompare(mStart, 0.0f) && (vCompare(mEnd, 1.0f))) ||
         (vCompare(mStart, 1.0f) && (vCompare(mEnd, 0.0f))))
-        return path;
-
-    float length = path.length();
-
-    if (mStart < mEnd) {
-        float array[4] = {
-            0.0f, length * mStart,  // 1st segment
-            (mEnd - mStart) * length,
-            rlottie_std::numeric_limits<float>::max(),  // 2nd segment
-        };
-        VDasher dasher(array, 4);
-        dasher.dashed(path, mScratchObject);
-        return mScratchObject;
-    } else {
-        float array[4] = {
-            length * mEnd, (mStart - mEnd) * length,  // 1st segment
-            (1 - mStart) * length,
-            rlottie_std::numeric_limits<float>::max(),  // 2nd segment
-        };
-        VDasher dasher(array, 4);
-        dasher.dashed(path, mScratchObject);
-        return mScratchObject;
+        return mPath;
+
+    if (!mResultDirty) return mScratchObject;
+    mResultDirty = false;
+
+    mScratchObject.reset();
+    mScratchObject.reserve(mPath.points().size(), mPath.elements().size());
+
+    float start = mLength * mStart;
+    float end = mLength * mEnd;
+    for (const auto &contour : mContours) {
+        if (mStart < mEnd) {
+            addSegment(contour, start, end);
+        } else {
+            addSegment(contour, 0.0f, end);
+            addSegment(contour, start, mLength);
+        }
     }
+    return mScratchObject;
+}
+
+VPath VPathMesure::trim(const VPath &path)
+{
+    setPath(path);
+    VPath result = trim();
+    // drop the reference so the caller can modify the path in place.
+    setPath(VPath());
+    mResultDirty = true;
+    return result;
 }
 
 V_END_NAMESPACE
@@ -25,14 +25,39 @@ V_BEGIN_NAMESPACE
 
 class VPathMesure {
 public:
-    void setRange(float start, float end) {mStart = start; mEnd = end;}
-    void  setStart(float start){mStart = start;}
-    void  setEnd(float end){mEnd = end;}
+    void setRange(float start, float end) {setStart(start); setEnd(end);}
+    void  setStart(float start);
+    void  setEnd(float end);
+    /*
+     * Keeps a reference to the path and builds its length table, which is
+     * reused by trim() until a different path is set. The table and the
+     * last trim result survive as long as the path data is shared.
+     */
+    void  setPath(const VPath &path);
+    float length() const {return mLength;}
+    VPath trim();
     VPath trim(const VPath &path);
 private:
-    float mStart{0.0f};
-    float mEnd{1.0f};
-    VPath mScratchObject;
+    struct Segment {
+        float    end;   // length from the contour start to the segment end
+        uint32_t point; // index of the segment start point
+        bool     cubic;
+    };
+    struct Contour {
+        size_t first;
+        size_t last;
+        float  length;
+    };
+    void addSegment(const Contour &contour, float from, float to);
+
+    float                          mStart{0.0f};
+    float                          mEnd{1.0f};
+    float                          mLength{0.0f};
+    bool                           mResultDirty{true};
+    VPath                          mPath;
+    rlottie_std::vector<Segment>   mSegments;
+    rlottie_std::vector<Contour>   mContours;
+    VPath                          mScratchObject;
 };
 
 V_END_NAMESPACE
@@ -272,8 +272,9 @@ public:
             rlottie_std::lock_guard<rlottie_std::mutex> lock(_mutex);
             _ready = true;
         }
-        _cv.notify_one();
+        _cv.notify_all();
     }
+    // several threads may wait for the same rle (e.g bands of a frame).
     void wait()
     {
         if (!_pending) return;
@@ -304,7 +305,7 @@ private:
     rlottie_std::mutex              _mutex;
     rlottie_std::condition_variable _cv;
     bool                    _ready{true};
-    bool                    _pending{false};
+    rlottie_std::atomic<bool> _pending{false};
 };
 
 struct VRleTask {
@@ -58,6 +58,7 @@ public:
 
     VRect intersected(const VRect &r) const;
     VRect operator&(const VRect &r) const;
+    VRect operator|(const VRect &r) const;
 
 private:
     int x1{0};
@@ -71,6 +72,20 @@ inline VRect VRect::intersected(const VRect &r) const
     return *this & r;
 }
 
+// bounding rect of both, an empty rect doesn't extend the other one.
+inline VRect VRect::operator|(const VRect &r) const
+{
+    if (empty()) return r;
+    if (r.empty()) return *this;
+
+    VRect tmp;
+    tmp.x1 = rlottie_std::min(x1, r.x1);
+    tmp.y1 = rlottie_std::min(y1, r.y1);
+    tmp.x2 = rlottie_std::max(x2, r.x2);
+    tmp.y2 = rlottie_std::max(y2, r.y2);
+    return tmp;
+}
+
 inline bool VRect::intersects(const VRect &r)
 {
     return (right() > r.left() && left() < r.right() && bottom() > r.top() &&
@@ -19,12 +19,13 @@
 #include "vrle.h"
 #include <vrect.h>
 #include <cstdlib>
+#include <limits>
 #include "vdebug.h"
 #include "vglobal.h"
 
 V_BEGIN_NAMESPACE
 
-enum class Operation { Add, Xor };
+enum class Operation { Add, Xor, Substract };
 
 struct VRleHelper {
     size_t      alloc{0};
@@ -34,9 +35,8 @@ struct VRleHelper {
 static void rleIntersectWithRle(VRleHelper *, int, int, VRleHelper *,
                                 VRleHelper *);
 static void rleIntersectWithRect(const VRect &, VRleHelper *, VRleHelper *);
-static void rleOpGeneric(VRleHelper *, VRleHelper *, VRleHelper *,
-                         Operation op);
-static void rleSubstractWithRle(VRleHelper *, VRleHelper *, VRleHelper *);
+static void rleOpRows(const VRle::VRleData &, const VRle::VRleData &,
+                      Operation, rlottie_std::vector<VRle::Span> &);
 
 static inline uchar divBy255(int x)
 {
@@ -113,6 +113,7 @@ void VRle::VRleData::addRect(const VRect &rect)
         span.coverage = 255;
         mSpans.push_back(span);
     }
+    mBboxDirty = true;
     updateBbox();
 }
 
@@ -172,9 +173,12 @@ void VRle::VRleData::opIntersect(const VRect &r, VRle::VRleSpanCb cb,
     tresult.alloc = array.size();
     tresult.spans = array.data();
 
-    // setup tmp object
-    tmp_obj.size = mSpans.size();
-    tmp_obj.spans = const_cast<VRle::Span *>(mSpans.data());
+    // setup tmp object, skipping the spans above the clip.
+    auto first = rlottie_std::lower_bound(
+        mSpans.begin(), mSpans.end(), clip.top(),
+        [](const VRle::Span &span, int y) { return span.y < y; });
+    tmp_obj.size = size_t(mSpans.end() - first);
+    tmp_obj.spans = const_cast<VRle::Span *>(mSpans.data()) + (first - mSpans.begin());
 
     // run till all the spans are processed
     while (tmp_obj.size) {
@@ -194,47 +198,7 @@ void VRle::VRleData::opSubstract(const VRle::VRleData &a,
     if (!a.bbox().intersects(b.bbox())) {
         mSpans = a.mSpans;
     } else {
-        VRle::Span *      aPtr = const_cast<VRle::Span *>(a.mSpans.data());
-        const VRle::Span *aEnd = a.mSpans.data() + a.mSpans.size();
-        VRle::Span *      bPtr = const_cast<VRle::Span *>(b.mSpans.data());
-        const VRle::Span *bEnd = b.mSpans.data() + b.mSpans.size();
-
-        // 1. forward till both y intersect
-        while ((aPtr != aEnd) && (aPtr->y < bPtr->y)) aPtr++;
-        size_t sizeA = size_t(aPtr - a.mSpans.data());
-        if (sizeA) copyArrayToVector(a.mSpans.data(), sizeA, mSpans);
-
-        // 2. forward b till it intersect with a.
-        while ((bPtr != bEnd) && (bPtr->y < aPtr->y)) bPtr++;
-        size_t sizeB = size_t(bPtr - b.mSpans.data());
-
-        // 2. calculate the intersect region
-        VRleHelper                  tresult, aObj, bObj;
-        rlottie_std::array<VRle::Span, 256> array;
-
-        // setup the tresult object
-        tresult.size = array.size();
-        tresult.alloc = array.size();
-        tresult.spans = array.data();
-
-        // setup a object
-        aObj.size = a.mSpans.size() - sizeA;
-        aObj.spans = aPtr;
-
-        // setup b object
-        bObj.size = b.mSpans.size() - sizeB;
-        bObj.spans = bPtr;
-
-        // run till all the spans are processed
-        while (aObj.size && bObj.size) {
-            rleSubstractWithRle(&aObj, &bObj, &tresult);
-            if (tresult.size) {
-                copyArrayToVector(tresult.spans, tresult.size, mSpans);
-            }
-            tresult.size = 0;
-        }
-        // 3. copy the rest of a
-        if (aObj.size) copyArrayToVector(aObj.spans, aObj.size, mSpans);
+        rleOpRows(a, b, Operation::Substract, mSpans);
     }
 
     mBboxDirty = true;
@@ -243,13 +207,14 @@ void VRle::VRleData::opSubstract(const VRle::VRleData &a,
 void VRle::VRleData::opGeneric(const VRle::VRleData &a, const VRle::VRleData &b,
                                OpCode code)
 {
-    // This routine assumes, obj1(span_y) < obj2(span_y).
-
     // reserve some space for the result vector.
     mSpans.reserve(a.mSpans.size() + b.mSpans.size());
 
-    // if two rle are disjoint
-    if (!a.bbox().intersects(b.bbox())) {
+    VRect aBox = a.bbox();
+    VRect bBox = b.bbox();
+    // if two rle don't share a row, one simply follows the other.
+    // rles side by side share rows even when their bbox are disjoint.
+    if (aBox.bottom() <= bBox.top() || bBox.bottom() <= aBox.top()) {
         if (a.mSpans[0].y < b.mSpans[0].y) {
             copyArrayToVector(a.mSpans.data(), a.mSpans.size(), mSpans);
             copyArrayToVector(b.mSpans.data(), b.mSpans.size(), mSpans);
@@ -258,58 +223,8 @@ void VRle::VRleData::opGeneric(const VRle::VRleData &a, const VRle::VRleData &b,
             copyArrayToVector(a.mSpans.data(), a.mSpans.size(), mSpans);
         }
     } else {
-        VRle::Span *      aPtr = const_cast<VRle::Span *>(a.mSpans.data());
-        const VRle::Span *aEnd = a.mSpans.data() + a.mSpans.size();
-        VRle::Span *      bPtr = const_cast<VRle::Span *>(b.mSpans.data());
-        const VRle::Span *bEnd = b.mSpans.data() + b.mSpans.size();
-
-        // 1. forward a till it intersects with b
-        while ((aPtr != aEnd) && (aPtr->y < bPtr->y)) aPtr++;
-        size_t sizeA = size_t(aPtr - a.mSpans.data());
-        if (sizeA) copyArrayToVector(a.mSpans.data(), sizeA, mSpans);
-
-        // 2. forward b till it intersects with a
-        while ((bPtr != bEnd) && (bPtr->y < aPtr->y)) bPtr++;
-        size_t sizeB = size_t(bPtr - b.mSpans.data());
-        if (sizeB) copyArrayToVector(b.mSpans.data(), sizeB, mSpans);
-
-        // 3. calculate the intersect region
-        VRleHelper                  tresult, aObj, bObj;
-        rlottie_std::array<VRle::Span, 256> array;
-
-        // setup the tresult object
-        tresult.size = array.size();
-        tresult.alloc = array.size();
-        tresult.spans = array.data();
-
-        // setup a object
-        aObj.size = a.mSpans.size() - sizeA;
-        aObj.spans = aPtr;
-
-        // setup b object
-        bObj.size = b.mSpans.size() - sizeB;
-        bObj.spans = bPtr;
-
-        Operation op = Operation::Add;
-        switch (code) {
-        case OpCode::Add:
-            op = Operation::Add;
-            break;
-        case OpCode::Xor:
-            op = Operation::Xor;
-            break;
-        }
-        // run till all the spans are processed
-        while (aObj.size && bObj.size) {
-            rleOpGeneric(&aObj, &bObj, &tresult, op);
-            if (tresult.size) {
-                copyArrayToVector(tresult.spans, tresult.size, mSpans);
-            }
-            tresult.size = 0;
-        }
-        // 3. copy the rest
-        if (bObj.size) copyArrayToVector(bObj.spans, bObj.size, mSpans);
-        if (aObj.size) copyArrayToVector(aObj.spans, aObj.size, mSpans);
+        rleOpRows(a, b, code == OpCode::Xor ? Operation::Xor : Operation::Add,
+                  mSpans);
     }
 
     mBboxDirty = true;
@@ -354,7 +269,7 @@ void VRle::VRleData::opIntersect(const VRle::VRleData &obj1,
                                  const VRle::VRleData &obj2)
 {
     opIntersectHelper(obj1, obj2, rle_cb, &mSpans);
-    updateBbox();
+    mBboxDirty = true;
 }
 
 #define VMIN(a, b) ((a) < (b) ? (a) : (b))
@@ -494,220 +409,126 @@ static void rleIntersectWithRect(const VRect &clip, VRleHelper *tmp_obj,
     result->size = result->alloc - available;
 }
 
-void blitXor(VRle::Span *spans, int count, uchar *buffer, int offsetX)
-{
-    while (count--) {
-        int    x = spans->x + offsetX;
-        int    l = spans->len;
-        uchar *ptr = buffer + x;
-        while (l--) {
-            int da = *ptr;
-            *ptr = divBy255((255 - spans->coverage) * (da) +
-                            spans->coverage * (255 - da));
-            ptr++;
-        }
-        spans++;
-    }
-}
-
-void blitDestinationOut(VRle::Span *spans, int count, uchar *buffer,
-                        int offsetX)
-{
-    while (count--) {
-        int    x = spans->x + offsetX;
-        int    l = spans->len;
-        uchar *ptr = buffer + x;
-        while (l--) {
-            *ptr = divBy255((255 - spans->coverage) * (*ptr));
-            ptr++;
-        }
-        spans++;
-    }
-}
-
-void blitSrcOver(VRle::Span *spans, int count, uchar *buffer, int offsetX)
+/*
+ * coverage of b composed on a, same as composing the spans on an
+ * alpha buffer that holds a.
+ */
+static inline uchar opCoverage(uchar a, uchar b, Operation op)
 {
-    while (count--) {
-        int    x = spans->x + offsetX;
-        int    l = spans->len;
-        uchar *ptr = buffer + x;
-        while (l--) {
-            *ptr = spans->coverage + divBy255((255 - spans->coverage) * (*ptr));
-            ptr++;
-        }
-        spans++;
+    switch (op) {
+    case Operation::Add:
+        return uchar(b + divBy255((255 - b) * a));
+    case Operation::Xor:
+        return divBy255((255 - b) * a + b * (255 - a));
+    case Operation::Substract:
+        return divBy255((255 - b) * a);
     }
+    return a;
 }
 
-void blit(VRle::Span *spans, int count, uchar *buffer, int offsetX)
+static inline void appendSpan(rlottie_std::vector<VRle::Span> &v, int x, int y,
+                              int len, uchar coverage)
 {
-    while (count--) {
-        int    x = spans->x + offsetX;
-        int    l = spans->len;
-        uchar *ptr = buffer + x;
-        while (l--) {
-            *ptr = rlottie_std::max(spans->coverage, *ptr);
-            ptr++;
+    if (!v.empty()) {
+        VRle::Span &last = v.back();
+        // extend the last span if it continues with the same coverage.
+        if (last.y == y && last.x + last.len == x &&
+            last.coverage == coverage) {
+            last.len = ushort(last.len + len);
+            return;
         }
-        spans++;
     }
+    VRle::Span span;
+    span.x = short(x);
+    span.y = short(y);
+    span.len = ushort(len);
+    span.coverage = coverage;
+    v.push_back(span);
 }
 
-size_t bufferToRle(uchar *buffer, int size, int offsetX, int y, VRle::Span *out)
+/*
+ * Combines the spans of a row of a and b, both sorted by x. The row is
+ * swept from one span edge to the next, so any width works.
+ */
+static void rleOpRow(const VRle::Span *a, const VRle::Span *aEnd,
+                     const VRle::Span *b, const VRle::Span *bEnd, Operation op,
+                     rlottie_std::vector<VRle::Span> &result)
 {
-    size_t count = 0;
-    uchar  value = buffer[0];
-    int    curIndex = 0;
-
-    size = offsetX < 0 ? size + offsetX : size;
-    for (int i = 0; i < size; i++) {
-        uchar curValue = buffer[0];
-        if (value != curValue) {
-            if (value) {
-                out->y = y;
-                out->x = offsetX + curIndex;
-                out->len = i - curIndex;
-                out->coverage = value;
-                out++;
-                count++;
+    int y = a->y;
+    int x = rlottie_std::min(a->x, b->x);
+
+    while (a < aEnd || b < bEnd) {
+        int   end = rlottie_std::numeric_limits<int>::max();
+        uchar aCoverage = 0;
+        uchar bCoverage = 0;
+
+        if (a < aEnd) {
+            if (a->x <= x) {
+                aCoverage = a->coverage;
+                end = a->x + a->len;
+            } else {
+                end = a->x;
             }
-            curIndex = i;
-            value = curValue;
         }
-        buffer++;
-    }
-    if (value) {
-        out->y = y;
-        out->x = offsetX + curIndex;
-        out->len = size - curIndex;
-        out->coverage = value;
-        count++;
-    }
-    return count;
-}
-
-static void rleOpGeneric(VRleHelper *a, VRleHelper *b, VRleHelper *result,
-                         Operation op)
-{
-    rlottie_std::array<VRle::Span, 256> temp;
-    VRle::Span *                out = result->spans;
-    size_t                      available = result->alloc;
-    VRle::Span *                aPtr = a->spans;
-    VRle::Span *                aEnd = a->spans + a->size;
-    VRle::Span *                bPtr = b->spans;
-    VRle::Span *                bEnd = b->spans + b->size;
-
-    while (available && aPtr < aEnd && bPtr < bEnd) {
-        if (aPtr->y < bPtr->y) {
-            *out++ = *aPtr++;
-            available--;
-        } else if (bPtr->y < aPtr->y) {
-            *out++ = *bPtr++;
-            available--;
-        } else {  // same y
-            VRle::Span *aStart = aPtr;
-            VRle::Span *bStart = bPtr;
-
-            int y = aPtr->y;
-
-            while (aPtr < aEnd && aPtr->y == y) aPtr++;
-            while (bPtr < bEnd && bPtr->y == y) bPtr++;
-
-            int aLength = (aPtr - 1)->x + (aPtr - 1)->len;
-            int bLength = (bPtr - 1)->x + (bPtr - 1)->len;
-            int offset = rlottie_std::min(aStart->x, bStart->x);
-
-            rlottie_std::array<uchar, 1024> array = {{0}};
-            blit(aStart, (aPtr - aStart), array.data(), -offset);
-            if (op == Operation::Add)
-                blitSrcOver(bStart, (bPtr - bStart), array.data(), -offset);
-            else if (op == Operation::Xor)
-                blitXor(bStart, (bPtr - bStart), array.data(), -offset);
-            VRle::Span *tResult = temp.data();
-            size_t size = bufferToRle(array.data(), rlottie_std::max(aLength, bLength),
-                                      offset, y, tResult);
-            if (available >= size) {
-                while (size--) {
-                    *out++ = *tResult++;
-                    available--;
-                }
+        if (b < bEnd) {
+            if (b->x <= x) {
+                bCoverage = b->coverage;
+                end = rlottie_std::min(end, b->x + b->len);
             } else {
-                aPtr = aStart;
-                bPtr = bStart;
-                break;
+                end = rlottie_std::min(end, int(b->x));
             }
         }
-    }
-    // update the span list that yet to be processed
-    a->spans = aPtr;
-    a->size = aEnd - aPtr;
 
-    // update the clip list that yet to be processed
-    b->spans = bPtr;
-    b->size = bEnd - bPtr;
+        if (end > x && (aCoverage || bCoverage)) {
+            uchar coverage = opCoverage(aCoverage, bCoverage, op);
+            if (coverage) appendSpan(result, x, y, end - x, coverage);
+        }
+        x = rlottie_std::max(x, end);
 
-    // update the result
-    result->size = result->alloc - available;
+        if (a < aEnd && a->x + a->len <= x) a++;
+        if (b < bEnd && b->x + b->len <= x) b++;
+    }
 }
 
-static void rleSubstractWithRle(VRleHelper *a, VRleHelper *b,
-                                VRleHelper *result)
+/*
+ * Combines a and b row by row. The rows of a alone are copied, the rows
+ * of b alone are dropped by Substract and copied otherwise.
+ */
+static void rleOpRows(const VRle::VRleData &a, const VRle::VRleData &b,
+                      Operation op, rlottie_std::vector<VRle::Span> &result)
 {
-    rlottie_std::array<VRle::Span, 256> temp;
-    VRle::Span *                out = result->spans;
-    size_t                      available = result->alloc;
-    VRle::Span *                aPtr = a->spans;
-    VRle::Span *                aEnd = a->spans + a->size;
-    VRle::Span *                bPtr = b->spans;
-    VRle::Span *                bEnd = b->spans + b->size;
-
-    while (available && aPtr < aEnd && bPtr < bEnd) {
+    const VRle::Span *aPtr = a.mSpans.data();
+    const VRle::Span *aEnd = aPtr + a.mSpans.size();
+    const VRle::Span *bPtr = b.mSpans.data();
+    const VRle::Span *bEnd = bPtr + b.mSpans.size();
+
+    while (aPtr < aEnd && bPtr < bEnd) {
         if (aPtr->y < bPtr->y) {
-            *out++ = *aPtr++;
-            available--;
+            const VRle::Span *start = aPtr;
+            while (aPtr < aEnd && aPtr->y < bPtr->y) aPtr++;
+            copyArrayToVector(start, size_t(aPtr - start), result);
         } else if (bPtr->y < aPtr->y) {
-            bPtr++;
+            const VRle::Span *start = bPtr;
+            while (bPtr < bEnd && bPtr->y < aPtr->y) bPtr++;
+            if (op != Operation::Substract)
+                copyArrayToVector(start, size_t(bPtr - start), result);
         } else {  // same y
-            VRle::Span *aStart = aPtr;
-            VRle::Span *bStart = bPtr;
+            const VRle::Span *aStart = aPtr;
+            const VRle::Span *bStart = bPtr;
 
             int y = aPtr->y;
 
             while (aPtr < aEnd && aPtr->y == y) aPtr++;
             while (bPtr < bEnd && bPtr->y == y) bPtr++;
 
-            int aLength = (aPtr - 1)->x + (aPtr - 1)->len;
-            int bLength = (bPtr - 1)->x + (bPtr - 1)->len;
-            int offset = rlottie_std::min(aStart->x, bStart->x);
-
-            rlottie_std::array<uchar, 1024> array = {{0}};
-            blit(aStart, (aPtr - aStart), array.data(), -offset);
-            blitDestinationOut(bStart, (bPtr - bStart), array.data(), -offset);
-            VRle::Span *tResult = temp.data();
-            size_t size = bufferToRle(array.data(), rlottie_std::max(aLength, bLength),
-                                      offset, y, tResult);
-            if (available >= size) {
-                while (size--) {
-                    *out++ = *tResult++;
-                    available--;
-                }
-            } else {
-                aPtr = aStart;
-                bPtr = bStart;
-                break;
-            }
+            rleOpRow(aStart, aPtr, bStart, bPtr, op, result);
         }
     }
-    // update the span list that yet to be processed
-    a->spans = aPtr;
-    a->size = size_t(aEnd - aPtr);
 
-    // update the clip list that yet to be processed
-    b->spans = bPtr;
-    b->size = size_t(bEnd - bPtr);
-
-    // update the result
-    result->size = result->alloc - available;
+    // copy the rest
+    if (aPtr < aEnd) copyArrayToVector(aPtr, size_t(aEnd - aPtr), result);
+    if (bPtr < bEnd && op != Operation::Substract)
+        copyArrayToVector(bPtr, size_t(bEnd - bPtr), result);
 }
 
 VRle VRle::toRle(const VRect &rect)
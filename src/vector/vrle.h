@@ -37,6 +37,7 @@ public:
     using VRleSpanCb =  void (*)(size_t count, const VRle::Span *spans,
                                  void *userData);
     bool  empty() const;
+    size_t spanCount() const;
     VRect boundingRect() const;
     void setBoundingRect(const VRect &bbox);
     void  addSpan(const VRle::Span *span, size_t count);
@@ -100,6 +101,11 @@ inline bool VRle::empty() const
     return d->empty();
 }
 
+inline size_t VRle::spanCount() const
+{
+    return d->mSpans.size();
+}
+
 inline void VRle::addSpan(const VRle::Span *span, size_t count)
 {
     d.write().addSpan(span, count);
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include "rlottie.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 
 class AnimationTest : public ::testing::Test {
 public:
@@ -32,3 +36,684 @@ TEST_F(AnimationTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+TEST_F(AnimationTest, renderRange) {
+    ASSERT_TRUE(animation != nullptr);
+    const size_t width = 100, height = 100;
+    size_t frameCount = animation->totalFrame();
+
+    std::vector<std::vector<uint32_t>> buffers(frameCount);
+    animation->renderRange(0, frameCount, 1, [&](size_t frameNo) {
+        buffers[frameNo].resize(width * height);
+        return rlottie::Surface(buffers[frameNo].data(), width, height,
+                                width * sizeof(uint32_t));
+    });
+
+    std::vector<uint32_t> expected(width * height);
+    for (size_t i = 0; i < frameCount; i++) {
+        rlottie::Surface surface(expected.data(), width, height,
+                                 width * sizeof(uint32_t));
+        animation->renderSync(i, surface);
+        ASSERT_EQ(buffers[i], expected);
+    }
+}
+
+TEST_F(AnimationTest, renderConcurrent) {
+    ASSERT_TRUE(animation != nullptr);
+    ASSERT_EQ(animation->maxConcurrentRender(), 1);
+    animation->setMaxConcurrentRender(4);
+    ASSERT_EQ(animation->maxConcurrentRender(), 4);
+
+    const size_t width = 100, height = 100;
+    size_t frameCount = 4;
+
+    std::vector<std::vector<uint32_t>> buffers(frameCount);
+    std::vector<std::future<rlottie::Surface>> results;
+    for (size_t i = 0; i < frameCount; i++) {
+        buffers[i].resize(width * height);
+        rlottie::Surface surface(buffers[i].data(), width, height,
+                                 width * sizeof(uint32_t));
+        results.push_back(animation->render(i * 7, surface));
+    }
+    for (auto &result : results) result.get();
+
+    std::vector<uint32_t> expected(width * height);
+    for (size_t i = 0; i < frameCount; i++) {
+        rlottie::Surface surface(expected.data(), width, height,
+                                 width * sizeof(uint32_t));
+        animation->renderSync(i * 7, surface);
+        ASSERT_EQ(buffers[i], expected);
+    }
+}
+
+TEST_F(AnimationTest, modelCache) {
+    std::string filePath = DEMO_DIR;
+    filePath +="mask.json";
+
+    // start from an empty cache, whatever the earlier tests left in it.
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(10);
+    auto before = rlottie::modelCacheStats();
+    ASSERT_EQ(before.count, 0u);
+    ASSERT_EQ(before.size, 0u);
+
+    auto loaded = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(loaded != nullptr);
+    auto after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.misses, before.misses + 1);
+    ASSERT_EQ(after.count, 1u);
+    ASSERT_GT(after.size, 0u);
+
+    before = after;
+    auto cached = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(cached != nullptr);
+    after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.hits, before.hits + 1);
+    ASSERT_EQ(after.misses, before.misses);
+
+    // a budget smaller than any model flushes the cache.
+    rlottie::configureModelCacheBudget(1);
+    after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.count, 0u);
+    ASSERT_EQ(after.size, 0u);
+    rlottie::configureModelCacheBudget(0);
+}
+
+TEST_F(AnimationTest, modelCacheConcurrentLoad) {
+    std::string filePath = DEMO_DIR;
+    filePath +="mask.json";
+    std::ifstream file(filePath);
+    std::string json((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+    // concurrent loads of a new key share a single parse.
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(10);
+    auto before = rlottie::modelCacheStats();
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<rlottie::Animation>> results(8);
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i]() {
+            results[i] = rlottie::Animation::loadFromData(json, "concurrentLoad",
+                                                          DEMO_DIR);
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    auto after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.misses, before.misses + 1);
+    ASSERT_EQ(after.hits, before.hits + results.size() - 1);
+    for (auto &result : results) {
+        ASSERT_TRUE(result != nullptr);
+        ASSERT_EQ(result->totalFrame(), 30);
+    }
+}
+
+TEST_F(AnimationTest, modelCacheLru) {
+    const std::vector<std::string> files = {"bell.json", "done.json", "dna.json",
+                                            "browser.json", "confetti.json",
+                                            "cooking.json"};
+    const size_t cacheSize = files.size() - 1;
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(cacheSize);
+
+    for (size_t i = 0; i < cacheSize; i++)
+        ASSERT_TRUE(rlottie::Animation::loadFromFile(DEMO_DIR + files[i]));
+    // touch the first one, the second one is now the least recently used.
+    ASSERT_TRUE(rlottie::Animation::loadFromFile(DEMO_DIR + files[0]));
+    ASSERT_TRUE(rlottie::Animation::loadFromFile(DEMO_DIR + files.back()));
+
+    auto before = rlottie::modelCacheStats();
+    ASSERT_EQ(before.count, cacheSize);
+    ASSERT_TRUE(rlottie::Animation::loadFromFile(DEMO_DIR + files[0]));
+    auto after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.hits, before.hits + 1);
+
+    ASSERT_TRUE(rlottie::Animation::loadFromFile(DEMO_DIR + files[1]));
+    after = rlottie::modelCacheStats();
+    ASSERT_EQ(after.misses, before.misses + 1);
+
+    rlottie::configureModelCacheSize(10);
+}
+
+static std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+}
+
+TEST_F(AnimationTest, loadFromMappedFile) {
+    std::string json = readFile(std::string(DEMO_DIR) + "mask.json");
+    ASSERT_FALSE(json.empty());
+    // a size that is a multiple of the page size leaves no room for the
+    // terminating zero inside the last page of the file.
+    json.append(16384 - json.size() % 16384, ' ');
+
+    std::string path = ::testing::TempDir() + "rlottie_mapped.json";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << json;
+    }
+    auto mapped = rlottie::Animation::loadFromFile(path, false);
+    auto expected = rlottie::Animation::loadFromData(json, "loadFromMappedFile",
+                                                     DEMO_DIR, false);
+    ASSERT_TRUE(mapped != nullptr && expected != nullptr);
+    ASSERT_EQ(mapped->totalFrame(), expected->totalFrame());
+
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> buffer(width * height), expectedBuffer(width * height);
+    rlottie::Surface surface(buffer.data(), width, height, width * sizeof(uint32_t));
+    mapped->renderSync(10, surface);
+    rlottie::Surface expectedSurface(expectedBuffer.data(), width, height,
+                                     width * sizeof(uint32_t));
+    expected->renderSync(10, expectedSurface);
+    ASSERT_EQ(buffer, expectedBuffer);
+
+    // the in-situ parse writes to a private copy, never to the file.
+    ASSERT_EQ(readFile(path), json);
+
+    // an empty file is not an animation.
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    }
+    ASSERT_FALSE(rlottie::Animation::loadFromFile(path, false));
+    std::remove(path.c_str());
+}
+
+TEST_F(AnimationTest, binaryModel) {
+    ASSERT_TRUE(animation != nullptr);
+    std::string binPath = ::testing::TempDir() + "mask.json.bin";
+    ASSERT_TRUE(animation->saveToBinary(binPath));
+
+    auto binary = rlottie::Animation::loadFromBinary(binPath, false);
+    ASSERT_TRUE(binary != nullptr);
+    ASSERT_EQ(binary->totalFrame(), animation->totalFrame());
+    ASSERT_EQ(binary->frameRate(), animation->frameRate());
+
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    for (size_t i = 0; i < animation->totalFrame(); i++) {
+        rlottie::Surface surface(expected.data(), width, height,
+                                 width * sizeof(uint32_t));
+        animation->renderSync(i, surface);
+        rlottie::Surface binSurface(result.data(), width, height,
+                                    width * sizeof(uint32_t));
+        binary->renderSync(i, binSurface);
+        ASSERT_EQ(result, expected);
+    }
+
+    // json resources are not binary models.
+    std::string filePath = DEMO_DIR;
+    filePath +="mask.json";
+    ASSERT_FALSE(rlottie::Animation::loadFromBinary(filePath, false));
+
+    // a corrupted blob is rejected, or loads a model that still renders.
+    std::string blob = readFile(binPath);
+    std::string corruptPath = ::testing::TempDir() + "mask.json.corrupt.bin";
+    for (size_t i = 0; i < blob.size(); i++) {
+        // a decremented object index refers to the group being read.
+        for (char value : {'\x00', '\x01', '\xff', char(blob[i] - 1)}) {
+            std::string corrupt = blob;
+            corrupt[i] = value;
+            {
+                std::ofstream file(corruptPath, std::ios::binary);
+                file << corrupt;
+            }
+            auto player = rlottie::Animation::loadFromBinary(corruptPath, false);
+            if (!player) continue;
+            rlottie::Surface surface(result.data(), width, height,
+                                     width * sizeof(uint32_t));
+            player->renderSync(0, surface);
+        }
+    }
+    std::remove(corruptPath.c_str());
+    std::remove(binPath.c_str());
+}
+
+TEST_F(AnimationTest, incrementalUpdate) {
+    std::string filePath = DEMO_DIR;
+    filePath +="insta_camera.json";
+    auto player = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(player != nullptr);
+
+    // a frame updated from any previous frame must look like a frame
+    // rendered by a fresh render tree.
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    size_t frameCount = player->totalFrame();
+    std::vector<size_t> frames;
+    for (size_t i = 0; i < frameCount; i++) frames.push_back(i);
+    for (size_t i = frameCount; i > 0; i -= std::min<size_t>(i, 7))
+        frames.push_back(i - 1);
+
+    for (auto frame : frames) {
+        rlottie::Surface surface(result.data(), width, height,
+                                 width * sizeof(uint32_t));
+        player->renderSync(frame, surface);
+
+        auto fresh = rlottie::Animation::loadFromFile(filePath);
+        rlottie::Surface freshSurface(expected.data(), width, height,
+                                      width * sizeof(uint32_t));
+        fresh->renderSync(frame, freshSurface);
+        ASSERT_EQ(result, expected) << "frame " << frame;
+    }
+}
+
+TEST_F(AnimationTest, frameStats) {
+    std::string filePath = DEMO_DIR;
+    filePath +="matte_two_item_with_lowerlayer.json";
+    auto player = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(player != nullptr);
+
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    for (size_t i = 0; i < player->totalFrame(); i++) {
+        rlottie::Surface surface(expected.data(), width, height,
+                                 width * sizeof(uint32_t));
+        player->renderSync(i, surface);
+
+        // collecting the stats must not change the rendering.
+        auto statsPlayer = rlottie::Animation::loadFromFile(filePath);
+        rlottie::FrameStats stats;
+        rlottie::Surface statsSurface(result.data(), width, height,
+                                      width * sizeof(uint32_t));
+        statsPlayer->renderSync(i, statsSurface, true, &stats);
+        ASSERT_EQ(result, expected);
+        ASSERT_GE(stats.updateTime, 0);
+        ASSERT_GE(stats.preprocessTime, 0);
+        ASSERT_GE(stats.matteTime, 0);
+        ASSERT_GT(stats.drawables, 0u);
+        ASSERT_GT(stats.rleSpans, 0u);
+        // the shape matte is only a coverage, no offscreen needed.
+        ASSERT_EQ(stats.offscreenBitmaps, 0u);
+    }
+}
+
+static std::string matteJson(int matteType)
+{
+    // an alpha matte of two squares side by side over a full red rect.
+    std::string transform =
+        R"("ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},)"
+        R"("a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]}},)"
+        R"("ip":0,"op":10,"st":0,)";
+    auto square = [](int x, int y, int size) {
+        return R"({"ty":"gr","it":[{"ty":"rc","d":1,"s":{"a":0,"k":[)" +
+               std::to_string(size) + "," + std::to_string(size) +
+               R"(]},"p":{"a":0,"k":[)" + std::to_string(x) + "," +
+               std::to_string(y) +
+               R"(]},"r":{"a":0,"k":0}},{"ty":"fl","c":{"a":0,"k":[1,1,1,1]},)"
+               R"("o":{"a":0,"k":100}},{"ty":"tr","o":{"a":0,"k":100},)"
+               R"("r":{"a":0,"k":0},"p":{"a":0,"k":[0,0]},"a":{"a":0,"k":[0,0]},)"
+               R"("s":{"a":0,"k":[100,100]}}]})";
+    };
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":10,"w":100,"h":100,"layers":[)"
+           R"({"ind":1,"ty":4,"td":1,)" + transform + R"("shapes":[)" +
+           square(25, 50, 30) + "," + square(75, 50, 30) + "]}," +
+           R"({"ind":2,"ty":4,"tt":)" + std::to_string(matteType) + "," +
+           transform + R"("shapes":[)" + R"({"ty":"rc","d":1,"s":{"a":0,"k":[100,100]},)"
+           R"("p":{"a":0,"k":[50,50]},"r":{"a":0,"k":0}},)"
+           R"({"ty":"fl","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100}}]}]})";
+}
+
+TEST_F(AnimationTest, matteMultipleShapes) {
+    // alpha matte and inverted alpha matte.
+    for (auto matte : {std::make_pair(1, 1800u), std::make_pair(2, 8200u)}) {
+        auto player = rlottie::Animation::loadFromData(
+            matteJson(matte.first), "matteMultipleShapes" +
+                                        std::to_string(matte.first), "", false);
+        ASSERT_TRUE(player != nullptr);
+
+        const size_t width = 100, height = 100;
+        std::vector<uint32_t> buffer(width * height);
+        rlottie::Surface surface(buffer.data(), width, height,
+                                 width * sizeof(uint32_t));
+        player->renderSync(0, surface);
+
+        size_t opaque = 0;
+        for (auto pixel : buffer) {
+            if (pixel == 0xffff0000) opaque++;
+            else ASSERT_EQ(pixel, 0u);
+        }
+        ASSERT_EQ(opaque, matte.second) << "matte type " << matte.first;
+    }
+}
+
+TEST_F(AnimationTest, renderBands) {
+    ASSERT_TRUE(animation != nullptr);
+    ASSERT_EQ(animation->maxRenderBands(), 1u);
+
+    for (auto name : {"mask.json", "matte_two_item_with_lowerlayer.json"}) {
+        std::string path = DEMO_DIR;
+        path += name;
+        auto player = rlottie::Animation::loadFromFile(path);
+        auto banded = rlottie::Animation::loadFromFile(path);
+        ASSERT_TRUE(player != nullptr && banded != nullptr);
+        banded->setMaxRenderBands(4);
+        ASSERT_EQ(banded->maxRenderBands(), 4u);
+
+        // bands of a frame must join without seams.
+        const size_t width = 256, height = 256;
+        std::vector<uint32_t> expected(width * height), result(width * height);
+        for (size_t i = 0; i < player->totalFrame(); i++) {
+            rlottie::Surface surface(expected.data(), width, height,
+                                     width * sizeof(uint32_t));
+            player->renderSync(i, surface);
+            rlottie::Surface bandSurface(result.data(), width, height,
+                                         width * sizeof(uint32_t));
+            banded->renderSync(i, bandSurface);
+            ASSERT_EQ(result, expected) << name << " frame " << i;
+        }
+    }
+}
+
+// FNV-1a of the bytes of the pixels, whatever the byte order of the host.
+static uint64_t frameHash(const std::vector<uint32_t> &pixels)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (auto pixel : pixels) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= (pixel >> shift) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+TEST_F(AnimationTest, flatContentOrder) {
+    // groups in groups, trims of both modes at several levels and a
+    // repeater around trimmed groups.
+    std::string path = DEMO_DIR;
+    path += "nested_trim_repeater.json";
+    auto player = rlottie::Animation::loadFromFile(path);
+    ASSERT_TRUE(player != nullptr);
+
+    // hashes of the frames drawn when the content tree was walked
+    // recursively, the flattened walk must not change a pixel.
+    const struct {
+        size_t   frame;
+        uint64_t hash;
+    } expected[] = {{0, 0xf4647a461bbafe00ull},
+                    {10, 0x105e7616e8dbbec6ull},
+                    {20, 0x9e18a71f1c3d7c45ull},
+                    {29, 0x781d03ed40652bc1ull}};
+    const size_t width = 200, height = 200;
+    std::vector<uint32_t> result(width * height);
+    for (const auto &frame : expected) {
+        rlottie::Surface surface(result.data(), width, height,
+                                 width * sizeof(uint32_t));
+        player->renderSync(frame.frame, surface);
+        ASSERT_EQ(frameHash(result), frame.hash) << "frame " << frame.frame;
+    }
+}
+
+static std::string renderListJson()
+{
+    auto animated = [](const std::string &from, const std::string &to, int start,
+                       int end) {
+        return R"({"a":1,"k":[{"t":)" + std::to_string(start) + R"(,"s":[)" + from +
+               R"(],"e":[)" + to + R"(],"i":{"x":[1],"y":[1]},"o":{"x":[0],"y":[0]}},)"
+               R"({"t":)" + std::to_string(end) + "}]}";
+    };
+    auto transform = [](int ip, int op) {
+        return R"("ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},)"
+               R"("a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]}},"ip":)" +
+               std::to_string(ip) + R"(,"op":)" + std::to_string(op) + R"(,"st":0,)";
+    };
+    std::string groupTransform =
+        R"({"ty":"tr","o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0]},)"
+        R"("a":{"a":0,"k":[0,0]},"s":{"a":0,"k":[100,100]}})";
+    // a square crossing the view whose fill fades out and back in.
+    std::string moving =
+        R"({"ty":"gr","it":[{"ty":"rc","d":1,"s":{"a":0,"k":[20,20]},"p":)" +
+        animated("-40,30", "140,30", 0, 30) + R"(,"r":{"a":0,"k":0}},)"
+        R"({"ty":"fl","c":{"a":0,"k":[1,0,0,1]},"o":{"a":1,"k":[)"
+        R"({"t":0,"s":[100],"e":[0],"i":{"x":[1],"y":[1]},"o":{"x":[0],"y":[0]}},)"
+        R"({"t":8,"s":[0],"e":[0],"i":{"x":[1],"y":[1]},"o":{"x":[0],"y":[0]}},)"
+        R"({"t":16,"s":[0],"e":[100],"i":{"x":[1],"y":[1]},"o":{"x":[0],"y":[0]}},)"
+        R"({"t":24}]}},)" + groupTransform + "]}";
+    // a trimmed stroked circle.
+    std::string trimmed =
+        R"({"ty":"gr","it":[{"ty":"el","d":1,"s":{"a":0,"k":[40,40]},)"
+        R"("p":{"a":0,"k":[50,70]}},{"ty":"tm","s":{"a":0,"k":0},"e":)" +
+        animated("0", "100", 0, 20) + R"(,"o":{"a":0,"k":0},"m":1},)"
+        R"({"ty":"st","c":{"a":0,"k":[0,1,0,1]},"o":{"a":0,"k":100},)"
+        R"("w":{"a":0,"k":4},"lc":2,"lj":2},)" + groupTransform + "]}";
+    // a growing row of repeated squares.
+    std::string repeated =
+        R"({"ty":"gr","it":[{"ty":"rc","d":1,"s":{"a":0,"k":[8,8]},)"
+        R"("p":{"a":0,"k":[10,90]},"r":{"a":0,"k":0}},)"
+        R"({"ty":"fl","c":{"a":0,"k":[0,0,1,1]},"o":{"a":0,"k":100}},)"
+        R"({"ty":"rp","c":)" + animated("1", "6", 0, 30) +
+        R"(,"o":{"a":0,"k":0},"m":1,"tr":{"ty":"tr","p":{"a":0,"k":[15,0]},)"
+        R"("a":{"a":0,"k":[0,0]},"s":{"a":0,"k":[100,100]},"r":{"a":0,"k":0},)"
+        R"("so":{"a":0,"k":100},"eo":{"a":0,"k":50}}},)" + groupTransform + "]}";
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,"layers":[)"
+           R"({"ind":1,"ty":4,)" + transform(0, 30) + R"("shapes":[)" + moving +
+           "," + trimmed + "]}," + R"({"ind":2,"ty":4,)" + transform(0, 30) +
+           R"("shapes":[)" + repeated + "]}," + R"({"ind":3,"ty":4,)" +
+           transform(10, 20) +
+           R"("shapes":[{"ty":"rc","d":1,"s":{"a":0,"k":[30,30]},)"
+           R"("p":{"a":0,"k":[50,50]},"r":{"a":0,"k":0}},)"
+           R"({"ty":"fl","c":{"a":0,"k":[1,1,0,1]},"o":{"a":0,"k":50}}]}]})";
+}
+
+TEST_F(AnimationTest, renderListReuse) {
+    // repeaters, trim paths, content fading out, leaving the view and a
+    // layer that shows up midway.
+    const std::string json = renderListJson();
+    auto load = [&](const char *key) {
+        return rlottie::Animation::loadFromData(json, key, "", false);
+    };
+    auto player = load("renderListReuse");
+    auto banded = load("renderListReuseBanded");
+    ASSERT_TRUE(player != nullptr && banded != nullptr);
+    banded->setMaxRenderBands(4);
+
+    const size_t width = 200, height = 200;
+    const size_t frameCount = player->totalFrame();
+    // start with the red square faded out, then forward and backward.
+    std::vector<size_t> frames = {12};
+    for (size_t i = 0; i < frameCount; i++) frames.push_back(i);
+    for (size_t i = frameCount; i--;) frames.push_back(i);
+
+    // the drawables kept from the previous frame must not change a pixel.
+    std::vector<uint32_t> expected(width * height), result(width * height),
+        bandResult(width * height);
+    for (auto frame : frames) {
+        auto fresh = load("renderListReuseFresh");
+        rlottie::Surface surface(expected.data(), width, height,
+                                 width * sizeof(uint32_t));
+        fresh->renderSync(frame, surface);
+
+        rlottie::Surface playerSurface(result.data(), width, height,
+                                       width * sizeof(uint32_t));
+        player->renderSync(frame, playerSurface);
+        ASSERT_EQ(result, expected) << "frame " << frame;
+
+        rlottie::Surface bandSurface(bandResult.data(), width, height,
+                                     width * sizeof(uint32_t));
+        banded->renderSync(frame, bandSurface);
+        ASSERT_EQ(bandResult, expected) << "banded frame " << frame;
+    }
+}
+
+TEST_F(AnimationTest, smoothImages) {
+    std::string path = DEMO_DIR;
+    path += "image_embedded.json";
+    auto player = rlottie::Animation::loadFromFile(path);
+    auto smooth = rlottie::Animation::loadFromFile(path);
+    ASSERT_TRUE(player != nullptr && smooth != nullptr);
+    ASSERT_FALSE(smooth->smoothImages());
+    smooth->setSmoothImages(true);
+    ASSERT_TRUE(smooth->smoothImages());
+
+    // the image is scaled down, filtering it changes the pixels.
+    const size_t width = 200, height = 200;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    rlottie::Surface surface(expected.data(), width, height,
+                             width * sizeof(uint32_t));
+    player->renderSync(0, surface);
+    // no image loader available.
+    if (std::all_of(expected.begin(), expected.end(),
+                    [](uint32_t pixel) { return !pixel; }))
+        return;
+    rlottie::Surface smoothSurface(result.data(), width, height,
+                                   width * sizeof(uint32_t));
+    smooth->renderSync(0, smoothSurface);
+    ASSERT_NE(result, expected);
+
+    smooth->setSmoothImages(false);
+    smooth->renderSync(0, smoothSurface);
+    ASSERT_EQ(result, expected);
+}
+
+TEST_F(AnimationTest, sharedImageDecode) {
+    // a fresh model, the image is decoded by the first render thread.
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(10);
+    std::string path = DEMO_DIR;
+    path += "image_embedded.json";
+
+    const size_t count = 4, width = 200, height = 200;
+    std::vector<std::unique_ptr<rlottie::Animation>> players;
+    for (size_t i = 0; i < count; i++) {
+        players.push_back(rlottie::Animation::loadFromFile(path));
+        ASSERT_TRUE(players.back() != nullptr);
+    }
+
+    std::vector<std::vector<uint32_t>> results(count);
+    std::vector<std::thread>           threads;
+    for (size_t i = 0; i < count; i++) {
+        results[i].resize(width * height);
+        threads.emplace_back([&, i]() {
+            rlottie::Surface surface(results[i].data(), width, height,
+                                     width * sizeof(uint32_t));
+            players[i]->renderSync(0, surface);
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    // no image loader available.
+    if (std::all_of(results[0].begin(), results[0].end(),
+                    [](uint32_t pixel) { return !pixel; }))
+        return;
+    for (size_t i = 1; i < count; i++) ASSERT_EQ(results[i], results[0]);
+
+    // the decoded image outlives the animations that used it.
+    players.clear();
+    auto player = rlottie::Animation::loadFromFile(path);
+    ASSERT_TRUE(player != nullptr);
+    std::vector<uint32_t> result(width * height);
+    rlottie::Surface surface(result.data(), width, height,
+                             width * sizeof(uint32_t));
+    player->renderSync(0, surface);
+    ASSERT_EQ(result, results[0]);
+}
+
+TEST_F(AnimationTest, partialUpdate) {
+    for (auto name : {"mask.json", "intelia_logo_animation.json"}) {
+        std::string path = DEMO_DIR;
+        path += name;
+        auto player = rlottie::Animation::loadFromFile(path);
+        auto partial = rlottie::Animation::loadFromFile(path);
+        ASSERT_TRUE(player != nullptr && partial != nullptr);
+        ASSERT_FALSE(partial->partialUpdate());
+        partial->setPartialUpdate(true);
+        ASSERT_TRUE(partial->partialUpdate());
+
+        // the frames drawn over the last one must match the full frames.
+        const size_t width = 200, height = 200;
+        std::vector<uint32_t> expected(width * height), result(width * height);
+        for (size_t i = 0; i < player->totalFrame(); i++) {
+            rlottie::Surface surface(expected.data(), width, height,
+                                     width * sizeof(uint32_t));
+            player->renderSync(i, surface);
+            rlottie::Surface partialSurface(result.data(), width, height,
+                                            width * sizeof(uint32_t));
+            // the dirty area is cleared even when the surface doesn't ask.
+            partialSurface.setNeedClear(i % 2 == 0);
+            partial->renderSync(i, partialSurface);
+            ASSERT_EQ(result, expected) << name << " frame " << i;
+
+            size_t x, y, w, h;
+            partial->dirtyRegion(x, y, w, h);
+            ASSERT_LE(x + w, width);
+            ASSERT_LE(y + h, height);
+            if (i == 0) ASSERT_EQ(w * h, width * height);
+        }
+    }
+}
+
+TEST_F(AnimationTest, bindProperty) {
+    std::string filePath = DEMO_DIR;
+    filePath +="insta_camera.json";
+    auto byKeyPath = rlottie::Animation::loadFromFile(filePath);
+    auto byHandle = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(byKeyPath && byHandle);
+
+    auto handle = byHandle->bindProperty("**", rlottie::Property::FillColor);
+    ASSERT_NE(handle, 0u);
+    ASSERT_EQ(byHandle->bindProperty("", rlottie::Property::FillColor), 0u);
+
+    // a value set through the handle renders like one set by keypath.
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    const rlottie::Color colors[] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    size_t frame = 0;
+    for (auto &color : colors) {
+        byKeyPath->setValue<rlottie::Property::FillColor>("**", color);
+        byHandle->setValue<rlottie::Property::FillColor>(handle, color);
+        // a handle of another property doesn't change the fill.
+        byHandle->setValue<rlottie::Property::StrokeColor>(handle, rlottie::Color(1, 1, 1));
+        byHandle->setValue<rlottie::Property::FillColor>(rlottie::PropertyHandle(0), rlottie::Color(1, 1, 1));
+
+        rlottie::Surface expectedSurface(expected.data(), width, height,
+                                         width * sizeof(uint32_t));
+        byKeyPath->renderSync(frame, expectedSurface);
+        rlottie::Surface surface(result.data(), width, height,
+                                 width * sizeof(uint32_t));
+        byHandle->renderSync(frame, surface);
+        ASSERT_EQ(result, expected);
+        frame += 5;
+    }
+}
+
+static rlottie::Color colorProvider(const rlottie::FrameInfo &, void *data)
+{
+    return *static_cast<rlottie::Color *>(data);
+}
+
+TEST_F(AnimationTest, valueProvider) {
+    std::string filePath = DEMO_DIR;
+    filePath +="insta_camera.json";
+    auto byValue = rlottie::Animation::loadFromFile(filePath);
+    auto byFunction = rlottie::Animation::loadFromFile(filePath);
+    auto byProvider = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(byValue && byFunction && byProvider);
+
+    // a plain value, a function and a function pointer with data agree.
+    rlottie::Color color(0.2f, 0.4f, 0.8f);
+    byValue->setValue<rlottie::Property::FillColor>("**", color);
+    byValue->setValue<rlottie::Property::FillOpacity>("**", 50.0f);
+    byFunction->setValue<rlottie::Property::FillColor>(
+        "**", [&](const rlottie::FrameInfo &) { return color; });
+    byFunction->setValue<rlottie::Property::FillOpacity>(
+        "**", [](const rlottie::FrameInfo &) { return 50.0f; });
+    byProvider->setValue<rlottie::Property::FillColor>("**", colorProvider, &color);
+    auto handle = byProvider->bindProperty("**", rlottie::Property::FillOpacity);
+    byProvider->setValue<rlottie::Property::FillOpacity>(
+        handle, [](const rlottie::FrameInfo &, void *) { return 50.0f; }, nullptr);
+
+    const size_t width = 100, height = 100;
+    std::vector<uint32_t> expected(width * height), result(width * height);
+    rlottie::Surface expectedSurface(expected.data(), width, height,
+                                     width * sizeof(uint32_t));
+    byValue->renderSync(10, expectedSurface);
+    for (auto &player : {byFunction.get(), byProvider.get()}) {
+        rlottie::Surface surface(result.data(), width, height,
+                                 width * sizeof(uint32_t));
+        player->renderSync(10, surface);
+        ASSERT_EQ(result, expected);
+    }
+}
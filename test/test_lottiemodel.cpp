@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "lottiemodel.h"
+#include <random>
+
+class LOTAnimInfoTest : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        // keyframes of 3 frames from 0 to 300, with a gap at [150, 160).
+        for (int start = 0; start < 300; start += 3) {
+            if (start >= 150 && start < 160) continue;
+            LOTKeyFrame<float> keyFrame;
+            keyFrame.mStartFrame = start;
+            keyFrame.mEndFrame = start + 3;
+            info.mKeyFrames.push_back(std::move(keyFrame));
+        }
+        info.mCursorSlot = 0;
+    }
+    // the keyframe containing the frame, by a linear scan.
+    const LOTKeyFrame<float> *expected(int frameNo) const
+    {
+        for (const auto &keyFrame : info.mKeyFrames) {
+            if (frameNo >= keyFrame.mStartFrame && frameNo < keyFrame.mEndFrame)
+                return &keyFrame;
+        }
+        return nullptr;
+    }
+public:
+    LOTAnimInfo<float> info;
+};
+
+TEST_F(LOTAnimInfoTest, findWithoutCursors) {
+    for (int frame = -5; frame < 305; frame++)
+        ASSERT_EQ(info.find(frame), expected(frame));
+}
+
+TEST_F(LOTAnimInfoTest, findForward) {
+    LOTKeyFrameCursors        cursors(1);
+    LOTKeyFrameCursors::Scope scope(&cursors);
+    for (int frame = -5; frame < 305; frame++)
+        ASSERT_EQ(info.find(frame), expected(frame));
+}
+
+TEST_F(LOTAnimInfoTest, findBackward) {
+    LOTKeyFrameCursors        cursors(1);
+    LOTKeyFrameCursors::Scope scope(&cursors);
+    for (int frame = 305; frame >= -5; frame--)
+        ASSERT_EQ(info.find(frame), expected(frame));
+}
+
+TEST_F(LOTAnimInfoTest, findRandom) {
+    LOTKeyFrameCursors        cursors(1);
+    LOTKeyFrameCursors::Scope scope(&cursors);
+    std::mt19937                       random(42);
+    std::uniform_int_distribution<int> frames(-5, 305);
+    for (int i = 0; i < 2000; i++) {
+        int frame = frames(random);
+        ASSERT_EQ(info.find(frame), expected(frame));
+    }
+}
+
+TEST_F(LOTAnimInfoTest, findInterleavedCursors) {
+    // two render trees at different frames of the same model.
+    LOTKeyFrameCursors first(1), second(1);
+    for (int frame = 0; frame < 300; frame++) {
+        {
+            LOTKeyFrameCursors::Scope scope(&first);
+            ASSERT_EQ(info.find(frame), expected(frame));
+        }
+        {
+            LOTKeyFrameCursors::Scope scope(&second);
+            ASSERT_EQ(info.find(299 - frame), expected(299 - frame));
+        }
+    }
+    // a table without the slot of the property is ignored.
+    LOTKeyFrameCursors        empty;
+    LOTKeyFrameCursors::Scope scope(&empty);
+    ASSERT_EQ(info.find(42), expected(42));
+}
+
+TEST(LOTKeyFrameValueTest, arcLengthTable) {
+    LOTKeyFrameValue<VPointF> value;
+    value.mStartValue = VPointF(0, 0);
+    value.mEndValue = VPointF(200, 50);
+    value.mOutTangent = VPointF(150, -120);
+    value.mInTangent = VPointF(-20, 160);
+    value.mPathKeyFrame = true;
+
+    // without the table the bezier is measured at every call.
+    std::vector<VPointF> points;
+    std::vector<float>   angles;
+    VBezier              bezier = value.bezier();
+    float                length = bezier.length();
+    for (int i = 0; i <= 100; i++) {
+        float t = i / 100.0f;
+        ASSERT_FLOAT_EQ(value.tAtProgress(t), bezier.tAtLength(t * length));
+        points.push_back(value.value(t));
+        angles.push_back(value.angle(t));
+    }
+
+    // the table stays within half a pixel and a degree of the measure.
+    value.prepare();
+    ASSERT_TRUE(value.mArcLength != nullptr);
+    for (int i = 0; i <= 100; i++) {
+        VPointF point = value.value(i / 100.0f);
+        ASSERT_NEAR(point.x(), points[i].x(), 0.5f);
+        ASSERT_NEAR(point.y(), points[i].y(), 0.5f);
+        ASSERT_NEAR(value.angle(i / 100.0f), angles[i], 1.0f);
+    }
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "vbitmap.h"
+
+class VBitmapPoolTest : public ::testing::Test {
+public:
+    // bytes of the buffer of a w x h ARGB bitmap, a power of two from 4096.
+    static size_t bucketBytes(size_t w, size_t h)
+    {
+        size_t bytes = 4096;
+        while (bytes < w * h * 4) bytes <<= 1;
+        return bytes;
+    }
+public:
+    VBitmapPool pool;
+};
+
+TEST_F(VBitmapPoolTest, acquire) {
+    auto bitmap = pool.acquire(100, 50);
+    ASSERT_TRUE(bitmap.bitmap().valid());
+    ASSERT_EQ(bitmap.bitmap().width(), 100u);
+    ASSERT_EQ(bitmap.bitmap().height(), 50u);
+    ASSERT_EQ(bitmap.bitmap().stride(), 400u);
+
+    auto mask = pool.acquire(101, 10, VBitmap::Format::Alpha8);
+    ASSERT_EQ(mask.bitmap().stride(), 104u);
+
+    ASSERT_FALSE(pool.acquire(0, 10).bitmap().valid());
+}
+
+TEST_F(VBitmapPoolTest, bucketReuse) {
+    uchar *data;
+    {
+        auto bitmap = pool.acquire(100, 100);
+        data = bitmap.bitmap().data();
+        ASSERT_EQ(pool.bytes(), 0u);
+    }
+    ASSERT_EQ(pool.bytes(), bucketBytes(100, 100));
+
+    // an other size of the same bucket gets the same buffer.
+    auto bitmap = pool.acquire(120, 120);
+    ASSERT_EQ(bucketBytes(120, 120), bucketBytes(100, 100));
+    ASSERT_EQ(bitmap.bitmap().data(), data);
+    ASSERT_EQ(pool.bytes(), 0u);
+
+    // moving the bitmap doesn't give the buffer back.
+    VBitmapPool::Bitmap moved(std::move(bitmap));
+    ASSERT_EQ(moved.bitmap().data(), data);
+    ASSERT_EQ(pool.bytes(), 0u);
+}
+
+TEST_F(VBitmapPoolTest, releaseOverMaxBytes) {
+    pool.setMaxBytes(bucketBytes(100, 100));
+    ASSERT_EQ(pool.maxBytes(), bucketBytes(100, 100));
+    {
+        auto first = pool.acquire(100, 100);
+        auto second = pool.acquire(100, 100);
+        ASSERT_NE(first.bitmap().data(), second.bitmap().data());
+    }
+    // only one of them fits, the other one is freed.
+    ASSERT_EQ(pool.bytes(), bucketBytes(100, 100));
+}
+
+TEST_F(VBitmapPoolTest, setMaxBytes) {
+    {
+        auto small = pool.acquire(32, 32);
+        auto medium = pool.acquire(64, 64);
+        auto large = pool.acquire(128, 128);
+    }
+    const size_t small = bucketBytes(32, 32), medium = bucketBytes(64, 64),
+                 large = bucketBytes(128, 128);
+    ASSERT_EQ(pool.bytes(), small + medium + large);
+
+    // the biggest buffers go first.
+    pool.setMaxBytes(small + medium + large - 1);
+    ASSERT_EQ(pool.bytes(), small + medium);
+    pool.setMaxBytes(small + medium - 1);
+    ASSERT_EQ(pool.bytes(), small);
+    pool.setMaxBytes(0);
+    ASSERT_EQ(pool.bytes(), 0u);
+}
+
+TEST_F(VBitmapPoolTest, oversizeNotKept) {
+    pool.setMaxBytes(size_t(-1));
+    {
+        // over the biggest bucket (2GB), the pixels are never touched.
+        auto bitmap = pool.acquire(32768, 16385);
+        ASSERT_TRUE(bitmap.bitmap().valid());
+    }
+    ASSERT_EQ(pool.bytes(), 0u);
+}
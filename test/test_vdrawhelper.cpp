@@ -0,0 +1,378 @@
+#include <gtest/gtest.h>
+#include "vdrawhelper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(VECTOR_AVX2_DISPATCH)
+
+extern void Vcomp_func_solid_Source_avx2(uint32_t *, int, uint32_t, uint32_t);
+extern void Vcomp_func_solid_SourceOver_avx2(uint32_t *, int, uint32_t, uint32_t);
+extern void Vcomp_func_solid_DestinationIn_avx2(uint32_t *, int, uint32_t, uint32_t);
+extern void Vcomp_func_solid_DestinationOut_avx2(uint32_t *, int, uint32_t, uint32_t);
+extern void Vcomp_func_Source_avx2(uint32_t *, const uint32_t *, int, uint32_t);
+extern void Vcomp_func_SourceOver_avx2(uint32_t *, const uint32_t *, int, uint32_t);
+extern void Vcomp_func_DestinationIn_avx2(uint32_t *, const uint32_t *, int, uint32_t);
+extern void Vcomp_func_DestinationOut_avx2(uint32_t *, const uint32_t *, int, uint32_t);
+extern void Vfetch_gradient_fixed_avx2(uint32_t *, int, const VGradientData *, int, int);
+extern void Vfetch_radial_avx2(uint32_t *, uint32_t *, const Operator *,
+                               const VSpanData *, float, float, float, float, float);
+extern void Vfetch_transformed_avx2(uint32_t *, int, const VBitmapData *, int, int,
+                                    int, int);
+extern void Vfetch_transformed_bilinear_avx2(uint32_t *, int, const VBitmapData *,
+                                             int, int, int, int);
+extern void Vmask_span_Add_avx2(uchar *, int, uint32_t);
+extern void Vmask_span_Subtract_avx2(uchar *, int, uint32_t);
+extern void Vmask_span_Intersect_avx2(uchar *, int, uint32_t);
+extern void Vmask_span_Difference_avx2(uchar *, int, uint32_t);
+
+// the C versions of vcompositionfunctions.cpp, the reference of the simd ones.
+extern CompositionFunction      COMP_functionForMode_C[];
+extern CompositionFunctionSolid COMP_functionForModeSolid_C[];
+
+/*
+ * reference versions of the fetch and mask functions, they follow
+ * vdrawhelper.cpp pixel by pixel.
+ */
+static uint32_t refGradientPixel(const VGradientData *grad, int ipos)
+{
+    const int size = VGradient::colorTableSize;
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        ipos = ipos % size;
+        ipos = ipos < 0 ? size + ipos : ipos;
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        ipos = ipos % (2 * size);
+        ipos = ipos < 0 ? 2 * size + ipos : ipos;
+        ipos = ipos >= size ? 2 * size - 1 - ipos : ipos;
+    } else {
+        ipos = std::min(std::max(ipos, 0), size - 1);
+    }
+    return grad->mColorTable[ipos];
+}
+
+static uint32_t refTexel(const VBitmapData *bitmap, int x, int y)
+{
+    x = std::min(std::max(x, bitmap->x1), bitmap->x2 - 1);
+    y = std::min(std::max(y, bitmap->y1), bitmap->y2 - 1);
+    return reinterpret_cast<const uint32_t *>(bitmap->scanLine(y))[x];
+}
+
+static uint32_t refBilinear(const VBitmapData *bitmap, int x, int y)
+{
+    int  x1 = x >> 16, y1 = y >> 16;
+    uint dx = uint(x & 0xffff) >> 8, dy = uint(y & 0xffff) >> 8;
+    uint top = INTERPOLATE_PIXEL_256(refTexel(bitmap, x1, y1), 256 - dx,
+                                     refTexel(bitmap, x1 + 1, y1), dx);
+    uint bottom = INTERPOLATE_PIXEL_256(refTexel(bitmap, x1, y1 + 1), 256 - dx,
+                                        refTexel(bitmap, x1 + 1, y1 + 1), dx);
+    return INTERPOLATE_PIXEL_256(top, 256 - dy, bottom, dy);
+}
+
+// the blit functions of the VRle ops in vrle.cpp.
+static uchar refMask(size_t op, int d, int c)
+{
+    auto div = [](int x) { return uchar((x + (x >> 8) + 0x80) >> 8); };
+    switch (op) {
+    case 0:
+        return uchar(c + div((255 - c) * d));
+    case 1:
+        return div((255 - c) * d);
+    case 2:
+        return div(c * d);
+    default:
+        return div((255 - c) * d + c * (255 - d));
+    }
+}
+
+class VDrawHelperAvx2Test : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        std::mt19937 rng(7);
+        for (size_t i = 0; i < Size; i++) {
+            src.push_back(pixel(rng));
+            dest.push_back(pixel(rng));
+        }
+        for (auto &c : colorTable.buffer32) c = pixel(rng);
+        data.mGradient.mColorTable = colorTable.buffer32;
+    }
+    // premultiplied pixel, with plenty of transparent and opaque ones.
+    static uint32_t pixel(std::mt19937 &rng)
+    {
+        uint32_t a = rng() % 4 == 0 ? 0 : rng() % 4 == 0 ? 255 : rng() % 256;
+        uint32_t c = a << 24;
+        for (int shift = 0; shift < 24; shift += 8)
+            c |= (a ? rng() % (a + 1) : 0) << shift;
+        return c;
+    }
+public:
+    static const size_t   Size = 67;
+    std::vector<uint32_t> src;
+    std::vector<uint32_t> dest;
+    VColorTable           colorTable;
+    VSpanData             data;
+};
+
+TEST_F(VDrawHelperAvx2Test, compositionFunctions) {
+    if (!vCpuSupportsAvx2()) return;
+
+    const CompositionFunctionSolid solid[] = {
+        Vcomp_func_solid_Source_avx2, Vcomp_func_solid_SourceOver_avx2,
+        Vcomp_func_solid_DestinationIn_avx2, Vcomp_func_solid_DestinationOut_avx2};
+    const CompositionFunction func[] = {
+        Vcomp_func_Source_avx2, Vcomp_func_SourceOver_avx2,
+        Vcomp_func_DestinationIn_avx2, Vcomp_func_DestinationOut_avx2};
+
+    for (size_t m = 0; m < 4; m++) {
+        for (uint32_t ca : {255u, 128u, 1u, 0u}) {
+            // every length and misalignment of a span.
+            for (size_t offset = 0; offset < 8; offset++) {
+                int length = int(Size - offset);
+                std::vector<uint32_t> result(dest), expected(dest);
+                func[m](result.data() + offset, src.data() + offset, length, ca);
+                COMP_functionForMode_C[m](expected.data() + offset,
+                                          src.data() + offset, length, ca);
+                ASSERT_EQ(result, expected) << "mode " << m << " alpha " << ca;
+
+                uint32_t color = src[offset];
+                result = dest;
+                expected = dest;
+                solid[m](result.data() + offset, length, color, ca);
+                COMP_functionForModeSolid_C[m](expected.data() + offset, length,
+                                               color, ca);
+                ASSERT_EQ(result, expected) << "solid mode " << m << " alpha " << ca;
+            }
+        }
+    }
+}
+
+TEST_F(VDrawHelperAvx2Test, gradientFetch) {
+    if (!vCpuSupportsAvx2()) return;
+
+    const VGradient::Spread spreads[] = {VGradient::Spread::Pad,
+                                         VGradient::Spread::Repeat,
+                                         VGradient::Spread::Reflect};
+    VGradientData *grad = &data.mGradient;
+    std::vector<uint32_t> result(Size), expected(Size);
+
+    for (auto spread : spreads) {
+        grad->mSpread = spread;
+        // positions running far outside the color table in both directions.
+        for (int inc : {3001, -2777, 96, 0}) {
+            for (int length : {int(Size), 7, 1}) {
+                int t = -40000;
+                Vfetch_gradient_fixed_avx2(result.data(), length, grad, t, inc);
+                for (int i = 0; i < length; i++, t += inc)
+                    expected[size_t(i)] = refGradientPixel(grad, (t + FIXPT_SIZE / 2) >> FIXPT_BITS);
+                ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + length,
+                                       result.begin()));
+            }
+        }
+    }
+
+    Operator op;
+    grad->mSpread = VGradient::Spread::Pad;
+    grad->radial.fradius = 2;
+    op.radial.dr = -0.5f;
+    for (bool extended : {false, true}) {
+        op.radial.extended = extended;
+        float det = -3, ddet = 0.5f, dddet = 0.01f, b = 0.7f, db = -0.01f;
+        Vfetch_radial_avx2(result.data(), result.data() + Size, &op, &data,
+                           det, ddet, dddet, b, db);
+        for (size_t i = 0; i < Size; i++) {
+            uint32_t color = 0;
+            if (!extended || det >= 0) {
+                float w = std::sqrt(det) - b;
+                if (!extended || grad->radial.fradius + op.radial.dr * w >= 0)
+                    color = refGradientPixel(grad, int(w * (VGradient::colorTableSize - 1) + 0.5f));
+            }
+            expected[i] = color;
+            det += ddet;
+            ddet += dddet;
+            b += db;
+        }
+        ASSERT_EQ(result, expected) << "extended " << extended;
+    }
+}
+
+TEST_F(VDrawHelperAvx2Test, textureFetch) {
+    if (!vCpuSupportsAvx2()) return;
+
+    // a 9x7 image with a 2 pixel clip border inside a 10 pixel stride.
+    std::vector<uint32_t> image(src);
+    image.resize(10 * 7, 0xff00ff00);
+    VBitmapData bitmap;
+    bitmap.imageData = reinterpret_cast<const uchar *>(image.data());
+    bitmap.width = 9;
+    bitmap.height = 7;
+    bitmap.x1 = 2;
+    bitmap.y1 = 2;
+    bitmap.x2 = 9;
+    bitmap.y2 = 7;
+    bitmap.bytesPerLine = 10 * sizeof(uint32_t);
+
+    std::vector<uint32_t> result(Size), expected(Size);
+    // scaled, rotated and mirrored walks starting outside the clip.
+    const int incs[][2] = {{65536, 0}, {20000, 0}, {-47000, 9000},
+                           {31000, -52000}, {0, 65536}};
+    for (auto &inc : incs) {
+        for (int length : {int(Size), 7, 1}) {
+            int x = -70000, y = 300000;
+            Vfetch_transformed_avx2(result.data(), length, &bitmap, x, y,
+                                    inc[0], inc[1]);
+            for (int i = 0; i < length; i++)
+                expected[size_t(i)] = refTexel(&bitmap, (x + i * inc[0]) >> 16,
+                                               (y + i * inc[1]) >> 16);
+            ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + length,
+                                   result.begin()));
+
+            Vfetch_transformed_bilinear_avx2(result.data(), length, &bitmap, x, y,
+                                             inc[0], inc[1]);
+            for (int i = 0; i < length; i++)
+                expected[size_t(i)] = refBilinear(&bitmap, x + i * inc[0],
+                                                  y + i * inc[1]);
+            ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + length,
+                                   result.begin()));
+        }
+    }
+}
+
+TEST_F(VDrawHelperAvx2Test, maskSpanFunctions) {
+    if (!vCpuSupportsAvx2()) return;
+
+    const MaskSpanFunction func[] = {
+        Vmask_span_Add_avx2, Vmask_span_Subtract_avx2,
+        Vmask_span_Intersect_avx2, Vmask_span_Difference_avx2};
+    std::vector<uchar> mask;
+    for (auto pixel : dest) {
+        mask.push_back(uchar(pixel));
+        mask.push_back(uchar(pixel >> 24));
+    }
+
+    for (size_t op = 0; op < 4; op++) {
+        for (uint32_t coverage : {255u, 200u, 128u, 1u, 0u}) {
+            for (size_t offset = 0; offset < 33; offset += 3) {
+                std::vector<uchar> result(mask), expected(mask);
+                func[op](result.data() + offset, int(mask.size() - offset),
+                         coverage);
+                for (size_t i = offset; i < mask.size(); i++)
+                    expected[i] = refMask(op, mask[i], int(coverage));
+                ASSERT_EQ(result, expected) << "op " << op << " coverage " << coverage;
+            }
+        }
+    }
+}
+
+#endif
+
+/*
+ * the mask buffer must give the coverage the rle ops give for the same masks,
+ * LOTLayerMaskItem picks either of them.
+ */
+class VMaskBufferTest : public ::testing::Test {
+public:
+    struct Mask {
+        VMaskBuffer::Op op;
+        VRle            rle;
+    };
+    // a rect rle whose spans get a coverage ramp along x.
+    static VRle rectRle(const VRect &r, uchar coverage)
+    {
+        std::vector<VRle::Span> spans;
+        for (int y = r.top(); y < r.bottom(); y++) {
+            for (int x = r.left(); x < r.right(); x += 4) {
+                VRle::Span span;
+                span.x = short(x);
+                span.y = short(y);
+                span.len = ushort(std::min(4, r.right() - x));
+                span.coverage = uchar(x % 8 ? coverage : coverage / 2 + 1);
+                spans.push_back(span);
+            }
+        }
+        VRle rle;
+        rle.addSpan(spans.data(), spans.size());
+        return rle;
+    }
+    static VRle opRle(const std::vector<Mask> &masks, const VRect &clip)
+    {
+        VRle rle;
+        for (auto &i : masks) {
+            switch (i.op) {
+            case VMaskBuffer::Op::Add:
+                rle = rle + i.rle;
+                break;
+            case VMaskBuffer::Op::Subtract:
+                if (rle.empty()) rle = VRle::toRle(clip);
+                rle = rle - i.rle;
+                break;
+            case VMaskBuffer::Op::Intersect:
+                if (rle.empty()) rle = VRle::toRle(clip);
+                rle = rle & i.rle;
+                break;
+            case VMaskBuffer::Op::Difference:
+                rle = rle ^ i.rle;
+                break;
+            }
+        }
+        return rle;
+    }
+    static VRle bufferRle(const std::vector<Mask> &masks, const VRect &clip)
+    {
+        VMaskBuffer buffer;
+        buffer.reset(clip);
+        for (auto &i : masks) {
+            if ((i.op == VMaskBuffer::Op::Subtract ||
+                 i.op == VMaskBuffer::Op::Intersect) && buffer.empty())
+                buffer.reset(clip, 255);
+            buffer.compose(i.rle, i.op);
+        }
+        return buffer.toRle();
+    }
+    struct Pixels {
+        std::vector<uchar> data;
+        VRect              rect;
+    };
+    static void fill(size_t count, const VRle::Span *spans, void *userData)
+    {
+        auto self = static_cast<Pixels *>(userData);
+        for (; count; --count, ++spans) {
+            size_t offset = size_t((spans->y - self->rect.top()) * self->rect.width() +
+                                   spans->x - self->rect.left());
+            memset(self->data.data() + offset, spans->coverage, spans->len);
+        }
+    }
+    static std::vector<uchar> coverage(const VRle &rle, const VRect &clip)
+    {
+        Pixels pixels{std::vector<uchar>(size_t(clip.width() * clip.height())), clip};
+        rle.intersect(clip, fill, &pixels);
+        return pixels.data;
+    }
+};
+
+TEST_F(VMaskBufferTest, sameCoverageAsRleOps) {
+    const VRect clip(0, 0, 64, 48);
+    // side by side shapes share rows, the last one spills out of the clip.
+    const VRle left = rectRle(VRect(4, 4, 20, 30), 255);
+    const VRle right = rectRle(VRect(30, 10, 20, 30), 200);
+    const VRle middle = rectRle(VRect(14, 0, 24, 48), 128);
+    const VRle spill = rectRle(VRect(50, 20, 30, 40), 77);
+    const VMaskBuffer::Op ops[] = {VMaskBuffer::Op::Add, VMaskBuffer::Op::Subtract,
+                                   VMaskBuffer::Op::Intersect,
+                                   VMaskBuffer::Op::Difference};
+
+    for (auto first : ops) {
+        for (auto second : ops) {
+            for (auto third : ops) {
+                std::vector<Mask> masks = {{first, left},
+                                           {VMaskBuffer::Op::Add, right},
+                                           {second, middle},
+                                           {third, spill}};
+                ASSERT_EQ(coverage(opRle(masks, clip), clip),
+                          coverage(bufferRle(masks, clip), clip))
+                    << int(first) << " " << int(second) << " " << int(third);
+            }
+        }
+    }
+}
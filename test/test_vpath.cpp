@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "vpath.h"
+#include "vpathmesure.h"
 
 class VPathTest : public ::testing::Test {
 public:
@@ -188,3 +189,35 @@ TEST_F(VPathTest, addPolystarZeroRoundness) {
     ASSERT_EQ(pathPolystarZero.elements().size() , pathPolystarZero.elements().capacity());
     ASSERT_EQ(pathPolystarZero.points().size() , pathPolystarZero.points().capacity());
 }
+
+TEST_F(VPathTest, trim) {
+    VPathMesure mesure;
+    mesure.setPath(pathRect);
+    ASSERT_FLOAT_EQ(mesure.length(), 400);
+
+    mesure.setRange(0.125, 0.375);
+    VPath path = mesure.trim();
+    ASSERT_EQ(path.segments() , 1);
+    ASSERT_FLOAT_EQ(path.length(), 100);
+
+    // start > end keeps both ends of the contour.
+    mesure.setRange(0.875, 0.125);
+    path = mesure.trim();
+    ASSERT_EQ(path.segments() , 2);
+    ASSERT_FLOAT_EQ(path.length(), 100);
+}
+
+TEST_F(VPathTest, trimCached) {
+    VPathMesure mesure;
+    mesure.setPath(pathCircle);
+    mesure.setRange(0.2, 0.7);
+    VPath path = mesure.trim();
+    ASSERT_NEAR(path.length(), pathCircle.length() / 2, 0.5);
+
+    // same path and range gives back the last result.
+    mesure.setPath(pathCircle);
+    ASSERT_TRUE(mesure.trim().sharedWith(path));
+
+    VPath trimmed = VPathMesure().trim(pathCircle);
+    ASSERT_TRUE(trimmed.sharedWith(pathCircle));
+}